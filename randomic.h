@@ -1,5 +1,5 @@
 /*
-randomic.h - Portable, single-file, atomic PRNG library, using the smallprng algorithm and standard atomics
+randomic.h - Portable, single-file, atomic PRNG library, using the smallprng algorithm and inline assembly or standard atomics
 
 To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring
 rights to this software to the public domain worldwide. This software is distributed without any warranty.
@@ -8,13 +8,46 @@ If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
 */
 
 /*
-randomic supports the following three configurations:
+randomic supports the following four configurations:
 #define RANDOMIC_EXTERN
     Default, should be used when using randomic in multiple compilation units within the same project.
 #define RANDOMIC_IMPLEMENTATION
     Must be defined in exactly one source file within a project for randomic to be found by the linker.
 #define RANDOMIC_STATIC
     Defines all randomic functions as static, useful if randomic is only used in a single compilation unit.
+#define RANDOMIC_INLINE
+    Combined with either of the first two in every source file, defines the functions called per value (randomicNext,
+    randomicBounded, the Float/Double conversions and their randomic_pool and randomic_team equivalents) as static inline in
+    each of them, so that they are inlined into (and can be vectorized with) the calling loops without link-time optimization.
+
+randomic also supports the following optional definitions:
+#define RANDOMIC_BUCKET_SIZE 262144
+    Size in bytes up to which randomicShuffleBuckets shuffles a bucket directly, should roughly match the L2 cache size.
+#define RANDOMIC_MALLOC malloc
+#define RANDOMIC_FREE free
+    Allocation functions for the scratch memory some functions need, must be defined together to replace the standard ones.
+#define RANDOMIC_NO_AESNI
+    Leaves out the AES-NI path of randomic_aes, which then always uses its (bit-exact but much slower) software fallback.
+#define RANDOMIC_NO_ASM
+    Leaves out the inline assembly that updates struct randomic with cmpxchg16b on x86-64, leaving it to the standard atomics,
+    which may fall back to a lock inside libatomic. Must be the same in every compilation unit.
+#define RANDOMIC_AARCH64_ASM
+    Opts in to the equivalent inline assembly for AArch64 (an ldaxp/stlxp loop), which is off by default as it has not been
+    tested on AArch64 hardware or under emulation yet. Must be the same in every compilation unit, and has no effect together
+    with RANDOMIC_NO_ASM.
+#define RANDOMIC_SAMPLING
+    Adds the sampling functions (randomicSampleIndices, struct randomic_sampler and struct randomic_reservoir), which use
+    <math.h>, so programs defining RANDOMIC_IMPLEMENTATION with it must link with -lm where libm is separate from libc.
+#define RANDOMIC_RELAXED
+    Updates all generators with relaxed rather than sequentially consistent atomics, which keeps every update atomic (no value
+    is ever returned twice or skipped) but no longer orders the calls against other memory accesses of the calling threads.
+#define RANDOMIC_XOSHIRO
+#define RANDOMIC_PCG
+#define RANDOMIC_ROMU
+#define RANDOMIC_LCG128
+    Replaces smallprng as the engine of struct randomic and randomic_pool with xoshiro128++, pcg32, romuquad32 or a 128-bit
+    LCG respectively. At most one of them may be defined, the same in every compilation unit, and RANDOMIC_ENGINE is set to the
+    engine's name. For the linear engines (xoshiro128++, pcg32 and the LCG) RANDOMIC_HAS_JUMP is defined as well.
 
 randomic usage:
     The struct randomic type represents a PRNG context and should be initialized and seeded using randomicSeed before usage.
@@ -23,6 +56,51 @@ randomic usage:
     For percentage chances the CO functions should be used, e.g. if (randomicFloat(...) < 0.5f) for a uniform 50% probability.
     For inclusive ranges the CC functions should be used, e.g. randomicFloat(...)*12.0f for an inclusive range of [0.0, 12.0].
     If needed randomicNext can be used to get the raw uint32 output of the pseudo-random generator (from 0 to UINT32_MAX).
+    randomicIsLockFree tells whether struct randomic is updated by lock-free instructions, which RANDOMIC_LOCK_FREE guarantees.
+    Every engine's step is invertible, so randomicPrev undoes the last step and returns the output it had produced, and
+    randomicRewind undoes the last n steps, e.g. to roll back a search or Markov chain without keeping snapshots of the state.
+    For integers in the range [0, n) randomicBounded should be used, as randomicNext(...)%n is biased for most values of n.
+    An array of n elements of any size can be shuffled with randomicShuffle, randomicShuffleU32/U64 are typed equivalents.
+    Arrays much larger than the last level cache shuffle faster with randomicShuffleBuckets, given a temp array of the same size.
+    randomicShuffleParallel spreads a shuffle across threads when compiled with OpenMP, and runs the same steps serially otherwise.
+    A struct randomic_perm visits every index in [0, n) in random order without storing a permutation, once initialized with
+    randomicPermInit, randomicPermAt returns the index at position i and randomicPermRange fills consecutive positions.
+    With RANDOMIC_SAMPLING, randomicSampleIndices picks k distinct indices from [0, n) in unspecified order, and a struct
+    randomic_sampler instead returns them one at a time in ascending order, once initialized with randomicSamplerInit, from
+    each call of randomicSamplerNext.
+    A struct randomic_reservoir keeps a uniform sample of k items from a stream of unknown length, initialized with either
+    randomicReservoirInit or randomicReservoirInitWeighted (weighted sampling, allocates) and released with randomicReservoirFree.
+    Items are offered with randomicReservoirOffer/OfferWeighted, which return the slot (0 to k-1) to store it in or SIZE_MAX to
+    drop it, while storing the items themselves is left to the caller. randomicReservoirSkip returns how many upcoming items will
+    be dropped anyway so they can be skipped in bulk. randomicReservoirMerge combines a reservoir into another, e.g. per thread.
+    randomicSplit seeds a child generator off a parent with a single atomic update, while randomicSpawn seeds the generator of a
+    numbered stream from a 64-bit seed, so that parallel tasks can get their streams independently of scheduling order.
+    Large arrays of generators are seeded faster with randomicSeedMany, which yields the same states as randomicSeed on each.
+    randomicParallelFill fills a buffer with random bytes from a 64-bit seed, spread across threads when compiled with OpenMP,
+    and yields the same bytes whatever the number of threads, so large reproducible datasets need not be generated serially.
+    A struct randomic_pool holds n independent non-atomic generators, e.g. one per entity, as separate a/b/c/d arrays. It is
+    allocated by randomicPoolInit, released with randomicPoolFree and seeded like randomicSeed or randomicSpawn per entity by
+    randomicPoolSeed or randomicPoolSpawn. randomicPoolStep steps all generators, randomicPoolStepMasked those with a nonzero
+    mask entry and randomicPoolStepIndexed those in a list of indices, all optionally storing the outputs, while randomicPoolNext
+    and randomicPoolFloatCO/CC and randomicPoolDoubleCO/CC step a single one and return its output like their counterparts.
+    A struct randomic_team holds a non-atomic generator per OpenMP thread, each on its own cache lines, allocated by
+    randomicTeamInit for a number of threads (omp_get_max_threads() if 0) and released with randomicTeamFree. randomicTeamSpawn
+    seeds all of them from a single 64-bit seed. Inside a parallel region randomicTeamNext, randomicTeamFloatCO/CC and
+    randomicTeamDoubleCO/CC return values of the calling thread's generator (by omp_get_thread_num(), 0 without OpenMP) and
+    randomicTeamFill stores its next n values, e.g. a block to be consumed by a #pragma omp simd loop. Each thread may only use
+    its own generator, and omp_get_thread_num() must be less than the number of threads the team was allocated for.
+    A struct randomic_philox is a counter-based generator, seeded with a 64-bit key and a 64-bit stream by randomicPhiloxSeed.
+    It has the same randomicPhiloxNext/FloatCO/FloatCC/DoubleCO/DoubleCC functions and randomicPhiloxFill for bulk output, but
+    randomicPhiloxSeek can also jump to any position of its stream, and randomicPhiloxAt returns the value at any position of any
+    stream without a generator at all. Value i of a stream is the same whether it was reached by stepping, seeking or directly.
+    A struct randomic_aes is another counter-based generator with the same API as randomic_philox (minus randomicPhiloxAt), i.e.
+    randomicAesSeed/Seek/Next/FloatCO/FloatCC/DoubleCO/DoubleCC/Fill, and randomicAesHardware tells whether AES-NI is used.
+    A struct randomic_chacha is a counter-based generator for when the quality of smallprng is not enough, with the same API as
+    randomic_aes, i.e. randomicChachaSeed/Seek/Next/FloatCO/FloatCC/DoubleCO/DoubleCC/Fill, with 8, 12 or 20 rounds given on seeding
+    (randomicChachaSeed returns 0 for any other number, so a generator is never run with rounds it doesn't implement).
+    With the linear engines (RANDOMIC_XOSHIRO, RANDOMIC_PCG or RANDOMIC_LCG128) randomicJump advances a generator by any number of
+    steps at once, as if randomicNext had been called that many times, and randomicLongJump by 2^64 steps, e.g. to hand each
+    thread or node its own non-overlapping substream of a single seed by long jumping once more for each of them.
 
 randomic details:
     For float, randomicFloatCO produces one of 2^24 possible values with perfect uniformity in its half-open range [0.0, 1.0),
@@ -30,10 +108,88 @@ randomic details:
     For double, randomicDoubleCO produces one of 2^32 possible values with perfect uniformity in its half-open range [0.0, 1.0),
     whereas randomicDoubleCC also produces one of 2^32 possible values with possibly less uniformity but a closed range [0.0, 1.0].
     With only 2^32 possible values these do not use all of double's available precision, but only require one call to randomicNext.
+    randomicRewind steps backwards one step at a time, except for the LCG engines which jump ahead by the rest of their period.
+    Note that everything built on randomicFork (shuffles, sampling, etc.) advances the generator by four steps per call.
+    A struct randomic is 16 bytes, which C11 atomics only update without a lock where the compiler inlines a 16-byte compare and
+    swap, as most compilers on x86-64 don't even with -mcx16 and call into libatomic instead, which may use a lock. Therefore
+    with GCC or Clang on x86-64 it is updated by inline assembly instead (lock cmpxchg16b), as it is on AArch64 by an
+    ldaxp/stlxp loop with RANDOMIC_AARCH64_ASM, which defines RANDOMIC_LOCK_FREE and needs no libatomic. cmpxchg16b is missing
+    on only the earliest x86-64 processors.
+    The loops read their first expected state with two plain loads, as a torn read just makes the first compare and swap fail.
+    A generator only needs its updates to be atomic, so RANDOMIC_RELAXED drops the barriers that sequential consistency adds
+    on weakly ordered processors (e.g. ldxp/stxp instead of ldaxp/stlxp on AArch64). On x86 every locked instruction is a full
+    barrier anyway, so it makes no difference there besides the position stores of the counter-based generators.
+    Only x86-64 builds have been checked with randomic_bench litmus, and as x86 never reorders around locked instructions,
+    that can't catch bugs that only show with weak memory ordering, so RANDOMIC_RELAXED is untested on such processors.
+    With RANDOMIC_INLINE only the functions called per value are compiled into every source file, everything else (seeding,
+    shuffles, etc.) is still defined once. Since the atomic update can't be vectorized, this mostly benefits loops over pools,
+    e.g. a loop storing randomicPoolFloatCO(pool, i) for every i vectorizes into the same code as randomicPoolStep.
+    randomicBounded uses the multiply-shift method, which is unbiased and only needs a division in the rare case of a rejection.
+    The shuffles are unbiased Fisher-Yates shuffles that step a private context forked off with a single atomic update, rather
+    than calling randomicNext per element, and draw up to four small bounds from one output when their product fits 32 bits.
+    randomicShuffleBuckets scatters elements into up to 256 buckets by uniform random labels and shuffles each bucket, recursing
+    until a bucket fits RANDOMIC_BUCKET_SIZE, which gives the same uniform permutations with mostly sequential memory access.
+    Arrays of elements larger than half of RANDOMIC_BUCKET_SIZE are shuffled directly, as no bucket of them could fit it.
+    randomicShuffleParallel shuffles one block per thread (rounded up to a power of two) and merges them pairwise as in MergeShuffle,
+    with every block and merge stepping its own stream derived from a single fork, so results depend only on seed and thread count.
+    randomic_perm is a six round Feistel network over the smallest power of two range covering n, keyed by randomicNext and
+    unbalanced by one bit for odd bit counts, positions that land outside [0, n) are walked along their cycle until they don't.
+    As the covering range is less than 2n this takes at most two rounds of the network per position on average. Like any block
+    cipher it only reaches a fraction of all n! permutations, so for exact uniformity over small arrays use the shuffles instead.
+    randomicSampleIndices uses Floyd's algorithm with a small hash set if k is at most n/64, a partial Fisher-Yates shuffle of
+    the whole range if k is at least n/4 and otherwise the sampler. Whenever allocating scratch memory fails it also falls back to
+    the sampler, which implements Vitter's Method D (switching to Method A once k is over n/13) and needs no memory at all.
+    Uniform reservoirs use Algorithm L and weighted ones A-ExpJ, both draw the length of the next skip (by count or by weight)
+    rather than deciding per item, so a stream of N items takes on the order of k*log(N/k) draws. Uniform reservoirs merge by
+    drawing the split between them from the hypergeometric distribution and weighted ones by keeping the largest keys, after which
+    Algorithm L's state is re-simulated, so merged reservoirs are distributed exactly as if they had seen both streams.
+    randomicSplit and randomicSpawn set the whole state through splitmix64 mixing, rather than spreading 32 bits by stepping like
+    randomicSeed does, and different seed and stream id pairs passed to randomicSpawn are guaranteed to yield different states.
+    randomicSeedMany runs the warm-up steps of randomicSeed on 16 states at once in separate a/b/c/d lanes, written so that
+    compilers vectorize the lanes (e.g. with -O3, or -O2 plus -ftree-vectorize on older compilers) without any intrinsics, and
+    writes the states without atomic stores, so it is meant for initialization rather than reseeding generators in use.
+    The pool kernels step lanes the same way as randomicSeedMany, masked steps compute every lane and select the results, so all
+    of them vectorize, except for the indexed step which depends on gathers and scatters. A pool is not safe to share between
+    threads unless they step disjoint sets of generators.
+    randomicParallelFill splits the buffer into fixed blocks of 64 KiB, the last one possibly shorter, and fills block i from
+    streams 16i to 16i+15 of the seed as set by randomicSpawn, stepped in lanes like randomicSeedMany with their outputs
+    interleaved, so every block only depends on the seed and its index and threads can fill any blocks in any order. Output
+    values are stored in native byte order, so the bytes match across thread counts but not across endianness.
+    Every generator of a struct randomic_team is sixteen lanes stepped together like the blocks of randomicParallelFill, and the
+    one of thread t uses the same streams as block t of randomicParallelFill with the same seed, so they produce the same values.
+    randomicTeamNext hands out the sixteen outputs of a step one at a time and randomicTeamFill stores whole steps directly, and
+    as lanes are stepped by a loop marked with #pragma omp simd, the cost per value is well below that of randomicNext.
+    randomic_philox implements Philox4x32-10 from Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", in which each
+    128-bit counter (the block index followed by the stream) is encrypted under the key by ten rounds, yielding four values.
+    As its only state is the position, the atomic version costs a single fetch-and-add rather than a compare-and-swap loop.
+    randomicPhiloxFill computes eight blocks at once with AVX2 if available at compile time (e.g. with -mavx2 or -march=native).
+    randomic_aes encrypts the 128-bit counter (the block index followed by the stream) with AES-128 under a key expanded from the
+    seed, yielding four values per block. With GCC or Clang on x86 the AES-NI instructions are used if the CPU supports them at
+    runtime, pipelining eight blocks at once in randomicAesFill, and otherwise a portable software AES with the same results.
+    randomic_chacha runs the ChaCha block function (D. J. Bernstein) on a key mixed from the seed, with the block index and the
+    stream in place of the counter and nonce, yielding sixteen values per block. ChaCha20 is a cryptographic stream cipher and its
+    reduced round variants ChaCha8/12 have no known practical attacks, but keys expanded from 64 bits are no substitute for a proper
+    cryptographic generator. randomicChachaFill computes eight blocks (512 bytes) at once with AVX2 if available at compile time,
+    using the rotate instructions of AVX-512VL where those are available too, which makes its cost per value similar to randomicNext.
+    randomicJump takes O(log steps) time: the LCG engines square the affine map of a single step as described by F. Brown in
+    "Random Number Generation with Arbitrary Strides", and xoshiro128++ squares the 128x128 matrix of its step over GF(2), which
+    at a few milliseconds for large step counts is slow enough that it is computed before the atomic update rather than during.
+    xoshiro128++ long jumps with the published jump polynomial and the LCG by squaring 64 times. As pcg32's period is only 2^64,
+    long jumping would be a no-op for it, so instead randomicLongJump moves it to the next of its 2^63 streams (the next odd
+    increment), which the design of PCG treats as distinct generators rather than as substreams of one sequence.
 
 randomic algorithm:
     Randomic uses the smallprng algorithm from http://burtleburtle.net/bob/rand/smallprng.html as it is public domain, which the
     more well-known alternatives (such as Mersenne Twister) are not. As described on the linked page, it is non-cryptographic.
+    The alternative engines all keep 128 bits of state, so struct randomic stays the same size and is updated the same way.
+    xoshiro128++ (Blackman and Vigna) is a linear engine with a nonlinear output function, pcg32 (O'Neill) a 64-bit LCG whose
+    upper half of the state holds the increment and whose output is permuted by a data-dependent rotation, and romuquad32
+    (Overton) a nonlinear engine of few instructions with good instruction-level parallelism, but with no guaranteed period.
+    Since their state needs more entropy than smallprng's, they are seeded from the seed spread by splitmix64 before warming up,
+    and derived states are adjusted to avoid invalid ones (the all-zero state, or an even pcg32 increment). With pcg32 this
+    leaves one state bit fixed, so different pairs passed to randomicSpawn may then coincide, albeit only at chance level.
+    The 128-bit LCG uses the multiplier and increment of PCG's 128-bit variant and returns the top 32 bits of the new state, as
+    the low bits of an LCG have short periods.
 */
 
 //include only once
@@ -47,10 +203,71 @@ randomic algorithm:
 #else //RANDOMIC_EXTERN
     #define RADEF extern
 #endif
+#ifdef RANDOMIC_INLINE
+    #define RAINL static inline
+#else
+    #define RAINL RADEF
+#endif
+#ifndef RANDOMIC_BUCKET_SIZE
+    #define RANDOMIC_BUCKET_SIZE 262144
+#endif
+#ifdef _OPENMP
+    #define RANDOMIC_OMP(...) _Pragma(#__VA_ARGS__)
+#else
+    #define RANDOMIC_OMP(...)
+#endif
+#if !defined(RANDOMIC_NO_AESNI) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define RANDOMIC_AESNI
+#endif
+#if !defined(RANDOMIC_NO_ASM) && defined(__GNUC__) && \
+    (defined(__x86_64__) || (defined(__aarch64__) && defined(RANDOMIC_AARCH64_ASM)))
+    #define RANDOMIC_LOCK_FREE
+#endif
+#ifdef RANDOMIC_RELAXED
+    #define RANDOMIC_ORDER memory_order_relaxed
+#else
+    #define RANDOMIC_ORDER memory_order_seq_cst
+#endif
+#if defined(RANDOMIC_XOSHIRO) + defined(RANDOMIC_PCG) + defined(RANDOMIC_ROMU) + defined(RANDOMIC_LCG128) > 1
+    #error "randomic: at most one of RANDOMIC_XOSHIRO, RANDOMIC_PCG, RANDOMIC_ROMU and RANDOMIC_LCG128 may be defined"
+#endif
+#if defined(RANDOMIC_XOSHIRO)
+    #define RANDOMIC_ENGINE "xoshiro128++"
+#elif defined(RANDOMIC_PCG)
+    #define RANDOMIC_ENGINE "pcg32"
+#elif defined(RANDOMIC_ROMU)
+    #define RANDOMIC_ENGINE "romuquad32"
+#elif defined(RANDOMIC_LCG128)
+    #define RANDOMIC_ENGINE "lcg128"
+#else
+    #define RANDOMIC_ENGINE "smallprng"
+#endif
+#if defined(RANDOMIC_XOSHIRO) || defined(RANDOMIC_PCG) || defined(RANDOMIC_LCG128)
+    #define RANDOMIC_HAS_JUMP
+#endif
 
 //includes
 #include <stdatomic.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+#ifdef RANDOMIC_SAMPLING
+    #include <math.h>
+#endif
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+#ifdef __AVX2__
+    #include <immintrin.h>
+#endif
+#ifdef RANDOMIC_AESNI
+    #include <wmmintrin.h>
+#endif
+#ifndef RANDOMIC_MALLOC
+    #include <stdlib.h>
+    #define RANDOMIC_MALLOC malloc
+    #define RANDOMIC_FREE free
+#endif
 
 //structs
 struct randomic {
@@ -59,68 +276,1894 @@ struct randomic {
     } ctx;
 };
 
+struct randomic_perm {
+    uint64_t n, keys[6];
+    int bits;
+};
+
+#ifdef RANDOMIC_SAMPLING
+struct randomic_sampler {
+    struct randomic_ctx ctx;
+    uint64_t n, k, pos;
+    double vprime;
+    int fresh;
+};
+
+struct randomic_reservoir {
+    struct randomic_ctx ctx;
+    uint64_t seen, next;
+    size_t k, size, *heap;
+    double w, *keys;
+};
+#endif
+
+struct randomic_pool {
+    uint32_t *a, *b, *c, *d;
+    size_t n;
+};
+
+struct randomic_member {
+    _Alignas(64) uint32_t a[16], b[16], c[16], d[16], out[16];
+    size_t used;
+};
+
+struct randomic_team {
+    struct randomic_member* members;
+    void* mem;
+    int n;
+};
+
+struct randomic_philox {
+    uint32_t key[2];
+    uint64_t stream;
+    _Atomic uint64_t pos;
+};
+
+struct randomic_aes {
+    uint8_t keys[176];
+    uint64_t stream;
+    _Atomic uint64_t pos;
+};
+
+struct randomic_chacha {
+    uint32_t key[8];
+    uint64_t stream;
+    int rounds;
+    _Atomic uint64_t pos;
+};
+
 //function declarations
 RADEF void randomicSeed(struct randomic*, uint32_t);
-RADEF float randomicFloatCO(struct randomic*);
-RADEF float randomicFloatCC(struct randomic*);
-RADEF double randomicDoubleCO(struct randomic*);
-RADEF double randomicDoubleCC(struct randomic*);
-RADEF uint32_t randomicNext(struct randomic*);
+RADEF int randomicIsLockFree(void);
+RAINL float randomicFloatCO(struct randomic*);
+RAINL float randomicFloatCC(struct randomic*);
+RAINL double randomicDoubleCO(struct randomic*);
+RAINL double randomicDoubleCC(struct randomic*);
+RAINL uint32_t randomicNext(struct randomic*);
+RADEF uint32_t randomicPrev(struct randomic*);
+RADEF void randomicRewind(struct randomic*, uint64_t);
+RAINL uint32_t randomicBounded(struct randomic*, uint32_t);
+RADEF void randomicShuffle(struct randomic*, void*, size_t, size_t);
+RADEF void randomicShuffleU32(struct randomic*, uint32_t*, size_t);
+RADEF void randomicShuffleU64(struct randomic*, uint64_t*, size_t);
+RADEF void randomicShuffleBuckets(struct randomic*, void*, void*, size_t, size_t);
+RADEF void randomicShuffleParallel(struct randomic*, void*, size_t, size_t, int);
+RADEF void randomicPermInit(struct randomic_perm*, struct randomic*, uint64_t);
+RADEF uint64_t randomicPermAt(const struct randomic_perm*, uint64_t);
+RADEF void randomicPermRange(const struct randomic_perm*, uint64_t, uint64_t*, size_t);
+#ifdef RANDOMIC_SAMPLING
+RADEF void randomicSampleIndices(struct randomic*, uint64_t, uint64_t, uint64_t*);
+RADEF void randomicSamplerInit(struct randomic_sampler*, struct randomic*, uint64_t, uint64_t);
+RADEF uint64_t randomicSamplerNext(struct randomic_sampler*);
+RADEF void randomicReservoirInit(struct randomic_reservoir*, struct randomic*, size_t);
+RADEF int randomicReservoirInitWeighted(struct randomic_reservoir*, struct randomic*, size_t);
+RADEF void randomicReservoirFree(struct randomic_reservoir*);
+RADEF size_t randomicReservoirOffer(struct randomic_reservoir*);
+RADEF size_t randomicReservoirOfferWeighted(struct randomic_reservoir*, double);
+RADEF uint64_t randomicReservoirSkip(struct randomic_reservoir*);
+RADEF void randomicReservoirMerge(struct randomic_reservoir*, const struct randomic_reservoir*, size_t*);
+#endif
+RADEF void randomicSplit(struct randomic*, struct randomic*);
+RADEF void randomicSpawn(struct randomic*, uint64_t, uint64_t);
+RADEF void randomicSeedMany(struct randomic*, const uint32_t*, size_t);
+RADEF void randomicParallelFill(uint64_t, void*, size_t, int);
+RADEF int randomicPoolInit(struct randomic_pool*, size_t);
+RADEF void randomicPoolFree(struct randomic_pool*);
+RADEF void randomicPoolSeed(struct randomic_pool*, const uint32_t*);
+RADEF void randomicPoolSpawn(struct randomic_pool*, uint64_t);
+RADEF void randomicPoolStep(struct randomic_pool*, uint32_t*);
+RADEF void randomicPoolStepMasked(struct randomic_pool*, const uint8_t*, uint32_t*);
+RADEF void randomicPoolStepIndexed(struct randomic_pool*, const size_t*, size_t, uint32_t*);
+RAINL uint32_t randomicPoolNext(struct randomic_pool*, size_t);
+RAINL float randomicPoolFloatCO(struct randomic_pool*, size_t);
+RAINL float randomicPoolFloatCC(struct randomic_pool*, size_t);
+RAINL double randomicPoolDoubleCO(struct randomic_pool*, size_t);
+RAINL double randomicPoolDoubleCC(struct randomic_pool*, size_t);
+RADEF int randomicTeamInit(struct randomic_team*, int);
+RADEF void randomicTeamFree(struct randomic_team*);
+RADEF void randomicTeamSpawn(struct randomic_team*, uint64_t);
+RADEF void randomicTeamFill(struct randomic_team*, uint32_t*, size_t);
+RAINL uint32_t randomicTeamNext(struct randomic_team*);
+RAINL float randomicTeamFloatCO(struct randomic_team*);
+RAINL float randomicTeamFloatCC(struct randomic_team*);
+RAINL double randomicTeamDoubleCO(struct randomic_team*);
+RAINL double randomicTeamDoubleCC(struct randomic_team*);
+RADEF void randomicPhiloxSeed(struct randomic_philox*, uint64_t, uint64_t);
+RADEF void randomicPhiloxSeek(struct randomic_philox*, uint64_t);
+RADEF float randomicPhiloxFloatCO(struct randomic_philox*);
+RADEF float randomicPhiloxFloatCC(struct randomic_philox*);
+RADEF double randomicPhiloxDoubleCO(struct randomic_philox*);
+RADEF double randomicPhiloxDoubleCC(struct randomic_philox*);
+RADEF uint32_t randomicPhiloxNext(struct randomic_philox*);
+RADEF void randomicPhiloxFill(struct randomic_philox*, uint32_t*, size_t);
+RADEF uint32_t randomicPhiloxAt(uint64_t, uint64_t, uint64_t);
+RADEF void randomicAesSeed(struct randomic_aes*, uint64_t, uint64_t);
+RADEF void randomicAesSeek(struct randomic_aes*, uint64_t);
+RADEF float randomicAesFloatCO(struct randomic_aes*);
+RADEF float randomicAesFloatCC(struct randomic_aes*);
+RADEF double randomicAesDoubleCO(struct randomic_aes*);
+RADEF double randomicAesDoubleCC(struct randomic_aes*);
+RADEF uint32_t randomicAesNext(struct randomic_aes*);
+RADEF void randomicAesFill(struct randomic_aes*, uint32_t*, size_t);
+RADEF int randomicAesHardware(void);
+RADEF int randomicChachaSeed(struct randomic_chacha*, uint64_t, uint64_t, int);
+RADEF void randomicChachaSeek(struct randomic_chacha*, uint64_t);
+RADEF float randomicChachaFloatCO(struct randomic_chacha*);
+RADEF float randomicChachaFloatCC(struct randomic_chacha*);
+RADEF double randomicChachaDoubleCO(struct randomic_chacha*);
+RADEF double randomicChachaDoubleCC(struct randomic_chacha*);
+RADEF uint32_t randomicChachaNext(struct randomic_chacha*);
+RADEF void randomicChachaFill(struct randomic_chacha*, uint32_t*, size_t);
+#ifdef RANDOMIC_HAS_JUMP
+RADEF void randomicJump(struct randomic*, uint64_t);
+RADEF void randomicLongJump(struct randomic*);
+#endif
+
+//inline section
+#if defined(RANDOMIC_INLINE) || defined(RANDOMIC_IMPLEMENTATION)
+
+//function declarations
+static float randomicToFloatCO(uint32_t);
+static float randomicToFloatCC(uint32_t);
+static double randomicToDoubleCO(uint32_t);
+static double randomicToDoubleCC(uint32_t);
+static struct randomic_ctx randomicLoad(struct randomic*);
+static int randomicCas(struct randomic*, struct randomic_ctx*, struct randomic_ctx);
+static uint32_t randomicStep(struct randomic_ctx*);
+static void randomicStepLanes(uint32_t*, uint32_t*, uint32_t*, uint32_t*, uint32_t*, size_t);
+static int randomicThread(void);
+#if defined(RANDOMIC_IMPLEMENTATION) || defined(RANDOMIC_LCG128)
+static uint64_t randomicMul64(uint64_t, uint64_t, uint64_t*);
+#endif
+#if (defined(RANDOMIC_IMPLEMENTATION) && defined(RANDOMIC_PCG)) || defined(RANDOMIC_LCG128)
+static void randomicMul128(uint64_t*, const uint64_t*);
+static void randomicAdd128(uint64_t*, const uint64_t*);
+static void randomicLcgMap(const struct randomic_ctx*, uint64_t*, uint64_t*, uint64_t*);
+#endif
+
+//public functions
+RAINL float randomicFloatCO (struct randomic* rdic) {
+    //returns a random float in the range [0.0, 1.0) (not including 1.0)
+    return randomicToFloatCO(randomicNext(rdic));
+}
+RAINL float randomicFloatCC (struct randomic* rdic) {
+    //returns a random float in the range [0.0, 1.0] (including 0.0 and 1.0)
+    return randomicToFloatCC(randomicNext(rdic));
+}
+RAINL double randomicDoubleCO (struct randomic* rdic) {
+    //returns a random double in the range [0.0, 1.0) (not including 1.0)
+    return randomicToDoubleCO(randomicNext(rdic));
+}
+RAINL double randomicDoubleCC (struct randomic* rdic) {
+    //returns a random double in the range [0.0, 1.0] (including 0.0 and 1.0)
+    return randomicToDoubleCC(randomicNext(rdic));
+}
+RAINL uint32_t randomicNext (struct randomic* rdic) {
+    //returns a random uint32 (raw output of the generator)
+    struct randomic_ctx ctx = randomicLoad(rdic), ntx;
+    uint32_t out;
+    do {
+        ntx = ctx;
+        out = randomicStep(&ntx);
+    } while (!randomicCas(rdic, &ctx, ntx));
+    return out;
+}
+RAINL uint32_t randomicBounded (struct randomic* rdic, uint32_t bound) {
+    //returns a random uint32 in the range [0, bound) (0 if bound is 0)
+    //multiply-shift, the low half decides rejection and only a rare candidate needs the division
+    uint64_t m = (uint64_t)randomicNext(rdic)*bound;
+    if ((uint32_t)m < bound) {
+        uint32_t t = (0u - bound)%bound;
+        while ((uint32_t)m < t)
+            m = (uint64_t)randomicNext(rdic)*bound;
+    }
+    return (uint32_t)(m >> 32);
+}
+RAINL uint32_t randomicPoolNext (struct randomic_pool* pool, size_t i) {
+    //steps generator i and returns its raw output
+    struct randomic_ctx ctx;
+    ctx.a = pool->a[i], ctx.b = pool->b[i], ctx.c = pool->c[i], ctx.d = pool->d[i];
+    uint32_t o = randomicStep(&ctx);
+    pool->a[i] = ctx.a, pool->b[i] = ctx.b, pool->c[i] = ctx.c, pool->d[i] = ctx.d;
+    return o;
+}
+RAINL float randomicPoolFloatCO (struct randomic_pool* pool, size_t i) {
+    //steps generator i and returns a random float in the range [0.0, 1.0) like randomicFloatCO
+    return randomicToFloatCO(randomicPoolNext(pool, i));
+}
+RAINL float randomicPoolFloatCC (struct randomic_pool* pool, size_t i) {
+    //steps generator i and returns a random float in the range [0.0, 1.0] like randomicFloatCC
+    return randomicToFloatCC(randomicPoolNext(pool, i));
+}
+RAINL double randomicPoolDoubleCO (struct randomic_pool* pool, size_t i) {
+    //steps generator i and returns a random double in the range [0.0, 1.0) like randomicDoubleCO
+    return randomicToDoubleCO(randomicPoolNext(pool, i));
+}
+RAINL double randomicPoolDoubleCC (struct randomic_pool* pool, size_t i) {
+    //steps generator i and returns a random double in the range [0.0, 1.0] like randomicDoubleCC
+    return randomicToDoubleCC(randomicPoolNext(pool, i));
+}
+RAINL uint32_t randomicTeamNext (struct randomic_team* team) {
+    //returns a random uint32 from the calling thread's generator, stepping its lanes once every sixteen values
+    struct randomic_member* m = &team->members[randomicThread()];
+    if (m->used == 16) {
+        randomicStepLanes(m->a, m->b, m->c, m->d, m->out, 16);
+        m->used = 0;
+    }
+    return m->out[m->used++];
+}
+RAINL float randomicTeamFloatCO (struct randomic_team* team) {
+    //returns a random float in the range [0.0, 1.0) from the calling thread's generator like randomicFloatCO
+    return randomicToFloatCO(randomicTeamNext(team));
+}
+RAINL float randomicTeamFloatCC (struct randomic_team* team) {
+    //returns a random float in the range [0.0, 1.0] from the calling thread's generator like randomicFloatCC
+    return randomicToFloatCC(randomicTeamNext(team));
+}
+RAINL double randomicTeamDoubleCO (struct randomic_team* team) {
+    //returns a random double in the range [0.0, 1.0) from the calling thread's generator like randomicDoubleCO
+    return randomicToDoubleCO(randomicTeamNext(team));
+}
+RAINL double randomicTeamDoubleCC (struct randomic_team* team) {
+    //returns a random double in the range [0.0, 1.0] from the calling thread's generator like randomicDoubleCC
+    return randomicToDoubleCC(randomicTeamNext(team));
+}
+
+//internal functions
+static float randomicToFloatCO (uint32_t x) {
+    //maps an output to the range [0.0, 1.0), with perfect uniformity but only 2^24 of 2^32 possible values
+    return (float)(x >> 8)/16777216.0f;
+}
+static float randomicToFloatCC (uint32_t x) {
+    //maps an output to the range [0.0, 1.0], using more of float's available precision at the cost of uniformity
+    return (float)x/(float)UINT32_MAX;
+}
+static double randomicToDoubleCO (uint32_t x) {
+    //maps an output to the range [0.0, 1.0), with perfect uniformity and a full 2^32 possible values
+    return (double)x/4294967296.0;
+}
+static double randomicToDoubleCC (uint32_t x) {
+    //maps an output to the range [0.0, 1.0], with possibly less uniformity as a result of the odd division
+    return (double)x/(double)UINT32_MAX;
+}
+static struct randomic_ctx randomicLoad (struct randomic* rdic) {
+    //returns the state of a generator as the first expected state of a compare and swap loop
+    #ifdef RANDOMIC_LOCK_FREE
+        //two plain loads which may tear, in which case the compare and swap fails and returns the actual state
+        const volatile uint64_t* p = (const volatile uint64_t*)(const volatile void*)&rdic->ctx;
+        uint64_t w[2] = {p[0], p[1]};
+        struct randomic_ctx ctx;
+        memcpy(&ctx, w, sizeof(ctx));
+        return ctx;
+    #else
+        return atomic_load_explicit(&rdic->ctx, RANDOMIC_ORDER);
+    #endif
+}
+static int randomicCas (struct randomic* rdic, struct randomic_ctx* expected, struct randomic_ctx desired) {
+    //replaces the state of a generator if it matches the expected one, or else stores the actual state to expected
+    #if defined(RANDOMIC_LOCK_FREE) && defined(__x86_64__)
+        uint64_t e[2], d[2];
+        unsigned char ok;
+        memcpy(e, expected, sizeof(e));
+        memcpy(d, &desired, sizeof(d));
+        __asm__ __volatile__ ("lock cmpxchg16b (%[p])\n\tsete %[ok]"
+            : [ok] "=q" (ok), "+a" (e[0]), "+d" (e[1])
+            : [p] "r" ((void*)&rdic->ctx), "b" (d[0]), "c" (d[1])
+            : "memory", "cc");
+        if (!ok) memcpy(expected, e, sizeof(e));
+        return ok;
+    #elif defined(RANDOMIC_LOCK_FREE)
+        //the pair is only read atomically if the exclusive store succeeds, so a mismatch stores the read state back
+        uint64_t e[2], d[2], o[2];
+        uint32_t fail;
+        memcpy(e, expected, sizeof(e));
+        memcpy(d, &desired, sizeof(d));
+        #ifdef RANDOMIC_RELAXED
+            #define RANDOMIC_LDXP "ldxp"
+            #define RANDOMIC_STXP "stxp"
+        #else
+            #define RANDOMIC_LDXP "ldaxp"
+            #define RANDOMIC_STXP "stlxp"
+        #endif
+        __asm__ __volatile__ (
+            "1: " RANDOMIC_LDXP " %[o0], %[o1], [%[p]]\n\t"
+            "cmp %[o0], %[e0]\n\t"
+            "ccmp %[o1], %[e1], #0, eq\n\t"
+            "b.ne 2f\n\t"
+            RANDOMIC_STXP " %w[f], %[d0], %[d1], [%[p]]\n\t"
+            "cbnz %w[f], 1b\n\t"
+            "b 3f\n"
+            "2: " RANDOMIC_STXP " %w[f], %[o0], %[o1], [%[p]]\n\t"
+            "cbnz %w[f], 1b\n\t"
+            "mov %w[f], #1\n"
+            "3:"
+            : [o0] "=&r" (o[0]), [o1] "=&r" (o[1]), [f] "=&r" (fail)
+            : [p] "r" ((void*)&rdic->ctx), [e0] "r" (e[0]), [e1] "r" (e[1]), [d0] "r" (d[0]), [d1] "r" (d[1])
+            : "memory", "cc");
+        #undef RANDOMIC_LDXP
+        #undef RANDOMIC_STXP
+        if (fail) memcpy(expected, o, sizeof(o));
+        return !fail;
+    #else
+        return atomic_compare_exchange_weak_explicit(&rdic->ctx, expected, desired, RANDOMIC_ORDER, RANDOMIC_ORDER);
+    #endif
+}
+static uint32_t randomicStep (struct randomic_ctx* ctx) {
+    //advances the PRNG state by a single step and returns its output
+    #if defined(RANDOMIC_XOSHIRO)
+        //xoshiro128++ with the state words s[0] to s[3] in a to d
+        uint32_t s = ctx->a + ctx->d, t = ctx->b << 9, out = ((s << 7)|(s >> 25)) + ctx->a;
+        ctx->c ^= ctx->a;
+        ctx->d ^= ctx->b;
+        ctx->b ^= ctx->c;
+        ctx->a ^= ctx->d;
+        ctx->c ^= t;
+        ctx->d = (ctx->d << 11)|(ctx->d >> 21);
+        return out;
+    #elif defined(RANDOMIC_PCG)
+        //pcg32 (XSH RR) with the state in a and b and the increment in c and d
+        uint64_t s = (uint64_t)ctx->a << 32|ctx->b, n = s*6364136223846793005u + ((uint64_t)ctx->c << 32|ctx->d);
+        uint32_t x = (uint32_t)(((s >> 18) ^ s) >> 27), r = (uint32_t)(s >> 59);
+        ctx->a = (uint32_t)(n >> 32);
+        ctx->b = (uint32_t)n;
+        return (x >> r)|(x << (-r & 31));
+    #elif defined(RANDOMIC_LCG128)
+        //128-bit lcg with the state in a to d (most significant word first), returning the top 32 bits
+        uint64_t s[2], mult[2], plus[2];
+        randomicLcgMap(ctx, s, mult, plus);
+        randomicMul128(s, mult);
+        randomicAdd128(s, plus);
+        ctx->a = (uint32_t)(s[0] >> 32), ctx->b = (uint32_t)s[0];
+        ctx->c = (uint32_t)(s[1] >> 32), ctx->d = (uint32_t)s[1];
+        return ctx->a;
+    #elif defined(RANDOMIC_ROMU)
+        //romuquad32 with the state words w, x, y and z in a to d
+        uint32_t w = ctx->a, x = ctx->b;
+        ctx->a = 3323815723u*ctx->d;
+        ctx->b = ctx->d + ((w << 26)|(w >> 6));
+        ctx->d = ctx->c + w;
+        ctx->c -= x;
+        ctx->d = (ctx->d << 9)|(ctx->d >> 23);
+        return x;
+    #else
+        uint32_t e = ctx->a - ((ctx->b << 27)|(ctx->b >> 5));
+        ctx->a = ctx->b ^ ((ctx->c << 17)|(ctx->c >> 15));
+        ctx->b = ctx->c + ctx->d;
+        ctx->c = ctx->d + e;
+        ctx->d = e + ctx->a;
+        return ctx->d;
+    #endif
+}
+static void randomicStepLanes (uint32_t* a, uint32_t* b, uint32_t* c, uint32_t* d, uint32_t* out, size_t n) {
+    //advances n states held in separate arrays by a single step, storing their outputs if out is not NULL
+    //every lane is independent, so these loops are meant to be vectorized, with the test of out hoisted out of them
+    //as a branch inside keeps them from vectorizing unless the compiler unswitches loops (e.g. at -O3)
+    if (!out) {
+        RANDOMIC_OMP(omp simd)
+        for (size_t i = 0; i < n; i++) {
+            struct randomic_ctx ctx;
+            ctx.a = a[i], ctx.b = b[i], ctx.c = c[i], ctx.d = d[i];
+            randomicStep(&ctx);
+            a[i] = ctx.a, b[i] = ctx.b, c[i] = ctx.c, d[i] = ctx.d;
+        }
+        return;
+    }
+    RANDOMIC_OMP(omp simd)
+    for (size_t i = 0; i < n; i++) {
+        struct randomic_ctx ctx;
+        ctx.a = a[i], ctx.b = b[i], ctx.c = c[i], ctx.d = d[i];
+        out[i] = randomicStep(&ctx);
+        a[i] = ctx.a, b[i] = ctx.b, c[i] = ctx.c, d[i] = ctx.d;
+    }
+}
+static int randomicThread (void) {
+    //returns the number of the calling thread in its OpenMP team, 0 without OpenMP
+    #ifdef _OPENMP
+        return omp_get_thread_num();
+    #else
+        return 0;
+    #endif
+}
+#if defined(RANDOMIC_IMPLEMENTATION) || defined(RANDOMIC_LCG128)
+static uint64_t randomicMul64 (uint64_t x, uint64_t y, uint64_t* lo) {
+    //full 64x64 bit multiplication, returns the high half and stores the low half
+    #ifdef __SIZEOF_INT128__
+        __extension__ unsigned __int128 m = (unsigned __int128)x*y;
+        *lo = (uint64_t)m;
+        return (uint64_t)(m >> 64);
+    #else
+        uint64_t ll = (x & 0xffffffff)*(y & 0xffffffff), lh = (x & 0xffffffff)*(y >> 32);
+        uint64_t hl = (x >> 32)*(y & 0xffffffff), hh = (x >> 32)*(y >> 32);
+        uint64_t mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+        *lo = mid << 32|(ll & 0xffffffff);
+        return hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    #endif
+}
+#endif
+#if (defined(RANDOMIC_IMPLEMENTATION) && defined(RANDOMIC_PCG)) || defined(RANDOMIC_LCG128)
+static void randomicMul128 (uint64_t* x, const uint64_t* y) {
+    //multiplies x by y modulo 2^128, both given as two words (most significant first), x may alias y
+    uint64_t lo, hi = randomicMul64(x[1], y[1], &lo);
+    hi += x[0]*y[1] + x[1]*y[0];
+    x[0] = hi, x[1] = lo;
+}
+static void randomicAdd128 (uint64_t* x, const uint64_t* y) {
+    //adds y to x modulo 2^128, both given as two words (most significant first)
+    x[1] += y[1];
+    x[0] += y[0] + (x[1] < y[1]);
+}
+static void randomicLcgMap (const struct randomic_ctx* ctx, uint64_t* s, uint64_t* mult, uint64_t* plus) {
+    //unpacks the state of an lcg-based engine and the multiplier and increment of its step, as 128-bit numbers
+    //pcg32 only uses the low words, which is fine as reducing modulo 2^64 commutes with the arithmetic modulo 2^128
+    #ifdef RANDOMIC_PCG
+        s[0] = 0, s[1] = (uint64_t)ctx->a << 32|ctx->b;
+        mult[0] = 0, mult[1] = 6364136223846793005u;
+        plus[0] = 0, plus[1] = (uint64_t)ctx->c << 32|ctx->d;
+    #else
+        s[0] = (uint64_t)ctx->a << 32|ctx->b, s[1] = (uint64_t)ctx->c << 32|ctx->d;
+        mult[0] = 0x2360ed051fc65da4, mult[1] = 0x4385df649fccf645;
+        plus[0] = 0x5851f42d4c957f2d, plus[1] = 0x14057b7ef767814f;
+    #endif
+}
+#endif
+
+#endif //RANDOMIC_INLINE
 
 //implementation section
 #ifdef RANDOMIC_IMPLEMENTATION
 
 //function declarations
-static struct randomic_ctx randomicStep(struct randomic_ctx);
+static void randomicStore(struct randomic*, struct randomic_ctx);
+static uint32_t randomicUnstep(struct randomic_ctx*);
+static struct randomic_ctx randomicInit(uint32_t);
+static void randomicSanitize(struct randomic_ctx*);
+static struct randomic_ctx randomicFork(struct randomic*);
+static struct randomic_ctx randomicBranch(struct randomic_ctx*);
+static struct randomic_ctx randomicDerive(const struct randomic_ctx*, uint64_t);
+static struct randomic_ctx randomicSpawnCtx(uint64_t, uint64_t);
+static uint64_t randomicMix64(uint64_t);
+static uint64_t randomicDraw64(struct randomic_ctx*);
+static uint32_t randomicDrawBounded(struct randomic_ctx*, uint32_t);
+static uint64_t randomicDrawBounded64(struct randomic_ctx*, uint64_t);
+static int randomicDrawBatch(struct randomic_ctx*, uint64_t, uint64_t*);
+#if defined(RANDOMIC_PCG) || defined(RANDOMIC_LCG128)
+static void randomicJumpLcg(struct randomic_ctx*, uint64_t, int);
+#endif
+#ifdef RANDOMIC_XOSHIRO
+static void randomicJumpMatrix(uint32_t (*)[4], uint64_t);
+static void randomicApplyMatrix(const uint32_t (*)[4], const uint32_t*, uint32_t*);
+#endif
+static void randomicSwap(unsigned char*, unsigned char*, size_t);
+static void randomicShuffleCtx(struct randomic_ctx*, unsigned char*, size_t, size_t);
+static int randomicScatter(struct randomic_ctx*, unsigned char*, unsigned char*, size_t, size_t);
+static void randomicMerge(struct randomic_ctx*, unsigned char*, size_t, size_t, size_t);
+static size_t randomicBlockStart(size_t, long, long);
+static uint64_t randomicFeistel(const struct randomic_perm*, uint64_t);
+#ifdef RANDOMIC_SAMPLING
+static double randomicDrawOpen(struct randomic_ctx*);
+static uint64_t randomicDrawIndex(struct randomic_ctx*, uint64_t);
+static uint64_t randomicSkipA(struct randomic_sampler*);
+static uint64_t randomicSkipD(struct randomic_sampler*);
+static int randomicSampleFloyd(struct randomic_ctx*, uint64_t, uint64_t, uint64_t*);
+static int randomicSampleDense(struct randomic_ctx*, uint64_t, uint64_t, uint64_t*);
+static void randomicReservoirResume(struct randomic_reservoir*);
+static void randomicReservoirPush(struct randomic_reservoir*, size_t, double);
+static void randomicReservoirReplace(struct randomic_reservoir*, double);
+#endif
+static void randomicFillBlock(uint64_t, uint64_t, unsigned char*, size_t);
+static void randomicPhiloxBlock(const uint32_t*, uint64_t, uint64_t, uint32_t*);
+static void randomicPhiloxBlocks(const uint32_t*, uint64_t, uint64_t, uint32_t*);
+static void randomicPhiloxRange(const uint32_t*, uint64_t, uint64_t, uint32_t*, size_t);
+static void randomicAesExpand(uint8_t*, uint64_t, uint64_t);
+static uint8_t randomicAesXtime(uint8_t);
+static void randomicAesSoft(const uint8_t*, uint64_t, uint64_t, uint32_t*);
+static void randomicAesRange(const struct randomic_aes*, uint64_t, uint32_t*, size_t);
+#ifdef RANDOMIC_AESNI
+static void randomicAesNI(const uint8_t*, uint64_t, uint64_t, uint32_t*, size_t);
+#endif
+static void randomicChachaBlock(const struct randomic_chacha*, uint64_t, uint32_t*);
+static void randomicChachaBlocks(const struct randomic_chacha*, uint64_t, uint32_t*);
+static void randomicChachaRange(const struct randomic_chacha*, uint64_t, uint32_t*, size_t);
 
 //public functions
 RADEF void randomicSeed (struct randomic* rdic, uint32_t seed) {
     //initialization as per smallprng algorithm
-    struct randomic_ctx ctx;
-    ctx.a = 0xf1ea5eed;
-    ctx.b = ctx.c = ctx.d = seed;
+    struct randomic_ctx ctx = randomicInit(seed);
     for (int i = 0; i < 20; i++)
-        ctx = randomicStep(ctx);
+        randomicStep(&ctx);
     //store initialized state atomically
-    atomic_store(&rdic->ctx, ctx);
+    randomicStore(rdic, ctx);
+}
+RADEF int randomicIsLockFree (void) {
+    //returns whether struct randomic is updated by lock-free instructions rather than a lock inside libatomic
+    #ifdef RANDOMIC_LOCK_FREE
+        return 1;
+    #else
+        struct randomic rdic;
+        return atomic_is_lock_free(&rdic.ctx);
+    #endif
+}
+RADEF void randomicSeedMany (struct randomic* rdics, const uint32_t* seeds, size_t n) {
+    //seeds n generators like randomicSeed, 16 at a time in lanes to allow vectorizing the warm-up
+    //states are written like atomic_init, so none of the generators may be in use by other threads meanwhile
+    uint32_t a[16], b[16], c[16], d[16];
+    for (size_t i = 0; i < n; i += 16) {
+        size_t m = n - i < 16 ? n - i : 16;
+        for (size_t j = 0; j < m; j++) {
+            struct randomic_ctx ctx = randomicInit(seeds[i + j]);
+            a[j] = ctx.a, b[j] = ctx.b, c[j] = ctx.c, d[j] = ctx.d;
+        }
+        for (int r = 0; r < 20; r++)
+            randomicStepLanes(a, b, c, d, NULL, m);
+        for (size_t j = 0; j < m; j++) {
+            struct randomic_ctx ctx;
+            ctx.a = a[j], ctx.b = b[j], ctx.c = c[j], ctx.d = d[j];
+            memcpy((void*)&rdics[i + j].ctx, &ctx, sizeof(ctx));
+        }
+    }
+}
+RADEF void randomicParallelFill (uint64_t seed, void* out, size_t bytes, int threads) {
+    //fills bytes of out with random data using the given number of threads with OpenMP, the same for any number of threads
+    unsigned char* ptr = out;
+    long blocks = (long)(bytes/65536 + (bytes%65536 != 0));
+    if (threads < 1) threads = 1;
+    RANDOMIC_OMP(omp parallel for num_threads(threads))
+    for (long i = 0; i < blocks; i++) {
+        size_t start = (size_t)i*65536;
+        randomicFillBlock(seed, (uint64_t)i, ptr + start, bytes - start < 65536 ? bytes - start : 65536);
+    }
+}
+RADEF uint32_t randomicPrev (struct randomic* rdic) {
+    //undoes the last step of the generator and returns its output, i.e. the value the matching randomicNext returned
+    struct randomic_ctx ctx = randomicLoad(rdic), ntx;
+    uint32_t out;
+    do {
+        ntx = ctx;
+        out = randomicUnstep(&ntx);
+    } while (!randomicCas(rdic, &ctx, ntx));
+    return out;
+}
+RADEF void randomicRewind (struct randomic* rdic, uint64_t n) {
+    //undoes the last n steps of the generator with a single atomic update
+    struct randomic_ctx ctx = randomicLoad(rdic), ntx;
+    do {
+        ntx = ctx;
+        #if defined(RANDOMIC_PCG) || defined(RANDOMIC_LCG128)
+            //the lcg engines jump ahead by the rest of their period (2^64 or 2^128) instead, in O(log n)
+            if (n) {
+                randomicJumpLcg(&ntx, 0 - n, 0);
+                #ifdef RANDOMIC_LCG128
+                    randomicJumpLcg(&ntx, UINT64_MAX, 64);
+                #endif
+            }
+        #else
+            for (uint64_t i = 0; i < n; i++)
+                randomicUnstep(&ntx);
+        #endif
+    } while (!randomicCas(rdic, &ctx, ntx));
+}
+RADEF void randomicShuffle (struct randomic* rdic, void* base, size_t n, size_t size) {
+    //shuffles an array of n elements of the given size uniformly (fisher-yates)
+    struct randomic_ctx ctx = randomicFork(rdic);
+    randomicShuffleCtx(&ctx, base, n, size);
+}
+RADEF void randomicShuffleU32 (struct randomic* rdic, uint32_t* base, size_t n) {
+    //shuffles an array of n uint32 uniformly (fisher-yates)
+    struct randomic_ctx ctx = randomicFork(rdic);
+    uint64_t js[4];
+    for (size_t i = n; i > 1;)
+        for (int k = randomicDrawBatch(&ctx, i, js), m = 0; m < k; m++, i--) {
+            uint32_t t = base[i - 1];
+            base[i - 1] = base[js[m]];
+            base[js[m]] = t;
+        }
+}
+RADEF void randomicShuffleU64 (struct randomic* rdic, uint64_t* base, size_t n) {
+    //shuffles an array of n uint64 uniformly (fisher-yates)
+    struct randomic_ctx ctx = randomicFork(rdic);
+    uint64_t js[4];
+    for (size_t i = n; i > 1;)
+        for (int k = randomicDrawBatch(&ctx, i, js), m = 0; m < k; m++, i--) {
+            uint64_t t = base[i - 1];
+            base[i - 1] = base[js[m]];
+            base[js[m]] = t;
+        }
+}
+RADEF void randomicShuffleBuckets (struct randomic* rdic, void* base, void* temp, size_t n, size_t size) {
+    //shuffles an array of n elements of the given size uniformly, temp must have room for n elements as well
+    //elements are scattered into buckets between base and temp, which are shuffled once they fit the cache
+    struct randomic_ctx ctx = randomicFork(rdic);
+    if (randomicScatter(&ctx, base, temp, n, size))
+        memcpy(base, temp, n*size);
+}
+RADEF void randomicShuffleParallel (struct randomic* rdic, void* base, size_t n, size_t size, int threads) {
+    //shuffles an array of n elements of the given size uniformly, using the given number of threads with OpenMP
+    //blocks are shuffled independently and then merged pairwise in log2(blocks) parallel rounds
+    struct randomic_ctx ctx = randomicFork(rdic);
+    unsigned char* ptr = base;
+    long blocks = 1;
+    if (threads < 1) threads = 1;
+    while (blocks < threads)
+        blocks *= 2;
+    RANDOMIC_OMP(omp parallel for num_threads(threads))
+    for (long i = 0; i < blocks; i++) {
+        struct randomic_ctx btx = randomicDerive(&ctx, (uint64_t)i);
+        size_t start = randomicBlockStart(n, blocks, i);
+        randomicShuffleCtx(&btx, ptr + start*size, randomicBlockStart(n, blocks, i + 1) - start, size);
+    }
+    for (long width = 1, round = 1; width < blocks; width *= 2, round++) {
+        RANDOMIC_OMP(omp parallel for num_threads(threads))
+        for (long i = 0; i < blocks; i += 2*width) {
+            struct randomic_ctx mtx = randomicDerive(&ctx, (uint64_t)blocks*round + i);
+            size_t start = randomicBlockStart(n, blocks, i);
+            randomicMerge(&mtx, ptr + start*size, randomicBlockStart(n, blocks, i + width) - start,
+                randomicBlockStart(n, blocks, i + 2*width) - start, size);
+        }
+    }
+}
+RADEF void randomicSplit (struct randomic* parent, struct randomic* child) {
+    //seeds child from parent, its state is mixed from four parent outputs claimed with a single atomic update
+    randomicStore(child, randomicFork(parent));
+}
+RADEF void randomicSpawn (struct randomic* rdic, uint64_t seed, uint64_t stream) {
+    //seeds the generator of the given stream of a seed, distinct seed and stream pairs always get distinct states
+    randomicStore(rdic, randomicSpawnCtx(seed, stream));
+}
+RADEF void randomicPermInit (struct randomic_perm* perm, struct randomic* rdic, uint64_t n) {
+    //initializes a random permutation of the range [0, n) with round keys drawn from the generator, n may be up to 2^63
+    perm->n = n;
+    perm->bits = 0;
+    while (perm->bits < 63 && ((uint64_t)1 << perm->bits) < n)
+        perm->bits++;
+    for (int i = 0; i < 6; i++) {
+        //the first output goes into the high half, drawn separately as the order of calls within an expression is unspecified
+        uint64_t hi = randomicNext(rdic);
+        perm->keys[i] = hi << 32|randomicNext(rdic);
+    }
+}
+RADEF uint64_t randomicPermAt (const struct randomic_perm* perm, uint64_t i) {
+    //returns the index at position i of the permutation, i must be in the range [0, n)
+    //cycle-walking, the network permutes the covering range so the cycle through i leads back into [0, n)
+    do i = randomicFeistel(perm, i);
+    while (i >= perm->n);
+    return i;
 }
-RADEF float randomicFloatCO (struct randomic* rdic) {
+RADEF void randomicPermRange (const struct randomic_perm* perm, uint64_t first, uint64_t* out, size_t count) {
+    //writes the indices at positions first to first+count-1 of the permutation to out
+    //positions go through the network eight at a time, so independent rounds overlap, only misses are walked one by one
+    for (size_t i = 0; i < count; i += 8) {
+        size_t m = count - i < 8 ? count - i : 8;
+        for (size_t j = 0; j < m; j++)
+            out[i + j] = randomicFeistel(perm, first + i + j);
+        for (size_t j = 0; j < m; j++)
+            while (out[i + j] >= perm->n)
+                out[i + j] = randomicFeistel(perm, out[i + j]);
+    }
+}
+#ifdef RANDOMIC_SAMPLING
+RADEF void randomicSampleIndices (struct randomic* rdic, uint64_t n, uint64_t k, uint64_t* out) {
+    //writes k distinct indices from the range [0, n) to out in unspecified order (k is capped at n)
+    //the method is picked by density, the sampler doubles as the fallback for failed allocations
+    struct randomic_sampler smp;
+    if (k > n) k = n;
+    if (k <= n/64) {
+        struct randomic_ctx ctx = randomicFork(rdic);
+        if (randomicSampleFloyd(&ctx, n, k, out)) return;
+    } else if (k >= n/4) {
+        struct randomic_ctx ctx = randomicFork(rdic);
+        if (randomicSampleDense(&ctx, n, k, out)) return;
+    }
+    randomicSamplerInit(&smp, rdic, n, k);
+    for (uint64_t i = 0; i < k; i++)
+        out[i] = randomicSamplerNext(&smp);
+}
+RADEF void randomicSamplerInit (struct randomic_sampler* smp, struct randomic* rdic, uint64_t n, uint64_t k) {
+    //initializes a sampler returning k distinct indices from the range [0, n) in ascending order (k is capped at n)
+    smp->ctx = randomicFork(rdic);
+    smp->n = n;
+    smp->k = k > n ? n : k;
+    smp->pos = 0;
+    smp->fresh = 0;
+}
+RADEF uint64_t randomicSamplerNext (struct randomic_sampler* smp) {
+    //returns the next index of the sample, or UINT64_MAX after all k have been returned
+    //each call draws the number of skipped records directly instead of deciding per record
+    uint64_t s;
+    if (!smp->k) return UINT64_MAX;
+    if (smp->k < smp->n/13) {
+        s = randomicSkipD(smp);
+    } else {
+        smp->fresh = 0;
+        s = randomicSkipA(smp);
+    }
+    smp->pos += s + 1;
+    smp->n -= s + 1;
+    smp->k--;
+    return smp->pos - 1;
+}
+RADEF void randomicReservoirInit (struct randomic_reservoir* res, struct randomic* rdic, size_t k) {
+    //initializes an empty reservoir for a uniform sample of k items
+    res->ctx = randomicFork(rdic);
+    res->seen = 0;
+    res->k = k;
+    res->size = 0;
+    res->heap = NULL;
+    res->keys = NULL;
+    randomicReservoirResume(res);
+}
+RADEF int randomicReservoirInitWeighted (struct randomic_reservoir* res, struct randomic* rdic, size_t k) {
+    //initializes an empty reservoir for a weighted sample of k items, returns 0 if allocation fails
+    randomicReservoirInit(res, rdic, k);
+    res->keys = RANDOMIC_MALLOC((k ? k : 1)*sizeof(double));
+    res->heap = RANDOMIC_MALLOC((k ? k : 1)*sizeof(size_t));
+    if (res->keys && res->heap) return 1;
+    randomicReservoirFree(res);
+    return 0;
+}
+RADEF void randomicReservoirFree (struct randomic_reservoir* res) {
+    //releases the memory of a weighted reservoir, does nothing for uniform ones
+    RANDOMIC_FREE(res->keys);
+    RANDOMIC_FREE(res->heap);
+    res->keys = NULL;
+    res->heap = NULL;
+}
+RADEF size_t randomicReservoirOffer (struct randomic_reservoir* res) {
+    //offers the next item to a uniform reservoir, returns the slot to store it in or SIZE_MAX if it is dropped
+    //algorithm L, w is the largest of k uniform keys and next the position where an item first beats it
+    uint64_t i = res->seen++;
+    if (i < res->k) return res->size++;
+    if (i < res->next) return SIZE_MAX;
+    res->w *= exp(log(randomicDrawOpen(&res->ctx))/(double)res->k);
+    double skip = floor(log(randomicDrawOpen(&res->ctx))/log1p(-res->w));
+    res->next = skip < (double)(UINT64_MAX - res->seen) ? res->seen + (uint64_t)skip : UINT64_MAX;
+    return (size_t)randomicDrawIndex(&res->ctx, res->k);
+}
+RADEF size_t randomicReservoirOfferWeighted (struct randomic_reservoir* res, double weight) {
+    //offers the next item with the given weight to a weighted reservoir, returns the slot or SIZE_MAX if it is dropped
+    //A-ExpJ, w is the weight left to skip before an item replaces the smallest key (keys are stored as logarithms)
+    if (!(weight > 0.0) || !res->k) return SIZE_MAX;
+    if (res->size < res->k) {
+        randomicReservoirPush(res, res->size, log(randomicDrawOpen(&res->ctx))/weight);
+        if (res->size == res->k)
+            res->w = log(randomicDrawOpen(&res->ctx))/res->keys[res->heap[0]];
+        return res->size - 1;
+    }
+    if ((res->w -= weight) > 0.0) return SIZE_MAX;
+    //the new key is drawn conditioned on beating the smallest one, as the skip already decided that it does
+    double t = exp(weight*res->keys[res->heap[0]]);
+    size_t slot = res->heap[0];
+    randomicReservoirReplace(res, log(t + (1.0 - t)*randomicDrawOpen(&res->ctx))/weight);
+    res->w = log(randomicDrawOpen(&res->ctx))/res->keys[res->heap[0]];
+    return slot;
+}
+RADEF uint64_t randomicReservoirSkip (struct randomic_reservoir* res) {
+    //returns how many upcoming items a uniform reservoir drops before accepting one, and counts them as offered
+    uint64_t skip = res->seen < res->k ? 0 : res->next - res->seen;
+    res->seen += skip;
+    return skip;
+}
+RADEF void randomicReservoirMerge (struct randomic_reservoir* dst, const struct randomic_reservoir* src, size_t* from) {
+    //merges src into dst (both uniform or both weighted, with the same k), afterwards dst is a sample of both streams
+    //from must have room for k entries, from[i] is the src slot whose item goes into dst slot i or SIZE_MAX to keep it
+    for (size_t i = 0; i < dst->k; i++)
+        from[i] = SIZE_MAX;
+    if (dst->keys) {
+        //weighted, keys are comparable across reservoirs so the largest k of both are kept
+        for (size_t i = 0; i < src->size; i++) {
+            if (dst->size < dst->k) {
+                from[dst->size] = i;
+                randomicReservoirPush(dst, dst->size, src->keys[i]);
+            } else if (src->keys[i] > dst->keys[dst->heap[0]]) {
+                from[dst->heap[0]] = i;
+                randomicReservoirReplace(dst, src->keys[i]);
+            }
+        }
+        if (dst->size == dst->k)
+            dst->w = log(randomicDrawOpen(&dst->ctx))/dst->keys[dst->heap[0]];
+        return;
+    }
+    //uniform, each pick takes from either stream in proportion to its remaining items (hypergeometric)
+    uint64_t na = dst->seen, nb = src->seen;
+    size_t total = dst->seen + src->seen < dst->k ? (size_t)(dst->seen + src->seen) : dst->k, ca = 0, cb = 0;
+    for (size_t i = 0; i < total; i++) {
+        if (randomicDrawIndex(&dst->ctx, na + nb) < na) na--, ca++;
+        else nb--, cb++;
+    }
+    //uniform subsets of both samples by selection sampling, src items replace dropped dst items first and then fill up
+    size_t drop = dst->size - ca, d = 0, si = 0, filled = dst->size;
+    for (size_t i = 0; i < cb; i++) {
+        while (randomicDrawIndex(&dst->ctx, src->size - si) >= cb - i)
+            si++;
+        if (i < drop) {
+            while (randomicDrawIndex(&dst->ctx, dst->size - d) >= drop - i)
+                d++;
+            from[d++] = si++;
+        } else from[filled++] = si++;
+    }
+    dst->size = total;
+    dst->seen += src->seen;
+    randomicReservoirResume(dst);
+}
+#endif
+RADEF int randomicPoolInit (struct randomic_pool* pool, size_t n) {
+    //allocates a pool of n generators which still need seeding, returns 0 if allocation fails
+    pool->a = n <= SIZE_MAX/4/sizeof(uint32_t) ? RANDOMIC_MALLOC((n ? n : 1)*4*sizeof(uint32_t)) : NULL;
+    if (!pool->a) {
+        randomicPoolFree(pool);
+        return 0;
+    }
+    pool->b = pool->a + n;
+    pool->c = pool->b + n;
+    pool->d = pool->c + n;
+    pool->n = n;
+    return 1;
+}
+RADEF void randomicPoolFree (struct randomic_pool* pool) {
+    //releases the memory of a pool
+    RANDOMIC_FREE(pool->a);
+    pool->a = pool->b = pool->c = pool->d = NULL;
+    pool->n = 0;
+}
+RADEF void randomicPoolSeed (struct randomic_pool* pool, const uint32_t* seeds) {
+    //seeds every generator of the pool like randomicSeed with its own seed
+    for (size_t i = 0; i < pool->n; i++) {
+        struct randomic_ctx ctx = randomicInit(seeds[i]);
+        pool->a[i] = ctx.a, pool->b[i] = ctx.b, pool->c[i] = ctx.c, pool->d[i] = ctx.d;
+    }
+    for (int r = 0; r < 20; r++)
+        randomicStepLanes(pool->a, pool->b, pool->c, pool->d, NULL, pool->n);
+}
+RADEF void randomicPoolSpawn (struct randomic_pool* pool, uint64_t seed) {
+    //seeds every generator of the pool like randomicSpawn, using its index as the stream
+    for (size_t i = 0; i < pool->n; i++) {
+        struct randomic_ctx ctx = randomicSpawnCtx(seed, i);
+        pool->a[i] = ctx.a, pool->b[i] = ctx.b, pool->c[i] = ctx.c, pool->d[i] = ctx.d;
+    }
+}
+RADEF void randomicPoolStep (struct randomic_pool* pool, uint32_t* out) {
+    //steps every generator once, storing output i to out[i] if out is not NULL
+    randomicStepLanes(pool->a, pool->b, pool->c, pool->d, out, pool->n);
+}
+RADEF void randomicPoolStepMasked (struct randomic_pool* pool, const uint8_t* mask, uint32_t* out) {
+    //steps the generators whose mask entry is nonzero, storing their outputs to out if it is not NULL
+    //blocks of lanes are stepped by randomicStepLanes on copies and blended back, so both loops vectorize without branches
+    uint32_t a[64], b[64], c[64], d[64], o[64], m[64];
+    for (size_t i = 0; i < pool->n; i += 64) {
+        size_t n = pool->n - i < 64 ? pool->n - i : 64;
+        memcpy(a, pool->a + i, n*sizeof(uint32_t));
+        memcpy(b, pool->b + i, n*sizeof(uint32_t));
+        memcpy(c, pool->c + i, n*sizeof(uint32_t));
+        memcpy(d, pool->d + i, n*sizeof(uint32_t));
+        randomicStepLanes(a, b, c, d, o, n);
+        for (size_t j = 0; j < n; j++) {
+            m[j] = mask[i + j] ? 0 : 0xffffffff;
+            a[j] ^= (a[j] ^ pool->a[i + j]) & m[j];
+            b[j] ^= (b[j] ^ pool->b[i + j]) & m[j];
+            c[j] ^= (c[j] ^ pool->c[i + j]) & m[j];
+            d[j] ^= (d[j] ^ pool->d[i + j]) & m[j];
+        }
+        memcpy(pool->a + i, a, n*sizeof(uint32_t));
+        memcpy(pool->b + i, b, n*sizeof(uint32_t));
+        memcpy(pool->c + i, c, n*sizeof(uint32_t));
+        memcpy(pool->d + i, d, n*sizeof(uint32_t));
+        if (out)
+            for (size_t j = 0; j < n; j++)
+                out[i + j] ^= (out[i + j] ^ o[j]) & ~m[j];
+    }
+}
+RADEF void randomicPoolStepIndexed (struct randomic_pool* pool, const size_t* idx, size_t count, uint32_t* out) {
+    //steps the generators listed in idx (which should not repeat), storing the output for idx[i] to out[i] if out is not NULL
+    for (size_t i = 0; i < count; i++) {
+        struct randomic_ctx ctx;
+        size_t j = idx[i];
+        ctx.a = pool->a[j], ctx.b = pool->b[j], ctx.c = pool->c[j], ctx.d = pool->d[j];
+        uint32_t o = randomicStep(&ctx);
+        pool->a[j] = ctx.a, pool->b[j] = ctx.b, pool->c[j] = ctx.c, pool->d[j] = ctx.d;
+        if (out) out[i] = o;
+    }
+}
+RADEF int randomicTeamInit (struct randomic_team* team, int n) {
+    //allocates a generator per thread for n threads (omp_get_max_threads() if n is 0), returns 0 if allocation fails
+    //members are aligned to cache lines by hand, as malloc only guarantees the alignment of the standard types
+    #ifdef _OPENMP
+        if (n < 1) n = omp_get_max_threads();
+    #endif
+    if (n < 1) n = 1;
+    team->mem = (size_t)n <= (SIZE_MAX - 63)/sizeof(struct randomic_member) ?
+        RANDOMIC_MALLOC((size_t)n*sizeof(struct randomic_member) + 63) : NULL;
+    if (!team->mem) {
+        randomicTeamFree(team);
+        return 0;
+    }
+    team->members = (struct randomic_member*)(((uintptr_t)team->mem + 63) & ~(uintptr_t)63);
+    team->n = n;
+    return 1;
+}
+RADEF void randomicTeamFree (struct randomic_team* team) {
+    //releases the memory of a team
+    RANDOMIC_FREE(team->mem);
+    team->mem = NULL;
+    team->members = NULL;
+    team->n = 0;
+}
+RADEF void randomicTeamSpawn (struct randomic_team* team, uint64_t seed) {
+    //seeds the generator of thread t from streams 16t to 16t+15 of the seed as set by randomicSpawn
+    for (int t = 0; t < team->n; t++) {
+        struct randomic_member* m = &team->members[t];
+        for (int j = 0; j < 16; j++) {
+            struct randomic_ctx ctx = randomicSpawnCtx(seed, 16*(uint64_t)t + (uint64_t)j);
+            m->a[j] = ctx.a, m->b[j] = ctx.b, m->c[j] = ctx.c, m->d[j] = ctx.d;
+        }
+        m->used = 16;
+    }
+}
+RADEF void randomicTeamFill (struct randomic_team* team, uint32_t* out, size_t n) {
+    //stores the next n values of the calling thread's generator to out, the same values n calls of randomicTeamNext return
+    struct randomic_member* m = &team->members[randomicThread()];
+    size_t i = 0;
+    while (i < n && m->used < 16)
+        out[i++] = m->out[m->used++];
+    for (; n - i >= 16; i += 16)
+        randomicStepLanes(m->a, m->b, m->c, m->d, out + i, 16);
+    if (i < n) {
+        randomicStepLanes(m->a, m->b, m->c, m->d, m->out, 16);
+        for (m->used = 0; i < n; i++)
+            out[i] = m->out[m->used++];
+    }
+}
+RADEF void randomicPhiloxSeed (struct randomic_philox* phx, uint64_t key, uint64_t stream) {
+    //initializes a philox generator at the start of the given stream of the given key
+    phx->key[0] = (uint32_t)key;
+    phx->key[1] = (uint32_t)(key >> 32);
+    phx->stream = stream;
+    atomic_store_explicit(&phx->pos, 0, RANDOMIC_ORDER);
+}
+RADEF void randomicPhiloxSeek (struct randomic_philox* phx, uint64_t pos) {
+    //moves a philox generator to the given position of its stream
+    atomic_store_explicit(&phx->pos, pos, RANDOMIC_ORDER);
+}
+RADEF float randomicPhiloxFloatCO (struct randomic_philox* phx) {
+    //returns a random float in the range [0.0, 1.0) (not including 1.0)
+    return randomicToFloatCO(randomicPhiloxNext(phx));
+}
+RADEF float randomicPhiloxFloatCC (struct randomic_philox* phx) {
+    //returns a random float in the range [0.0, 1.0] (including 0.0 and 1.0)
+    return randomicToFloatCC(randomicPhiloxNext(phx));
+}
+RADEF double randomicPhiloxDoubleCO (struct randomic_philox* phx) {
+    //returns a random double in the range [0.0, 1.0) (not including 1.0)
+    return randomicToDoubleCO(randomicPhiloxNext(phx));
+}
+RADEF double randomicPhiloxDoubleCC (struct randomic_philox* phx) {
+    //returns a random double in the range [0.0, 1.0] (including 0.0 and 1.0)
+    return randomicToDoubleCC(randomicPhiloxNext(phx));
+}
+RADEF uint32_t randomicPhiloxNext (struct randomic_philox* phx) {
+    //returns a random uint32 (raw output of the generator)
+    uint32_t out;
+    randomicPhiloxRange(phx->key, phx->stream, atomic_fetch_add_explicit(&phx->pos, 1, RANDOMIC_ORDER), &out, 1);
+    return out;
+}
+RADEF void randomicPhiloxFill (struct randomic_philox* phx, uint32_t* out, size_t n) {
+    //writes the next n outputs to out, claimed from the generator with a single atomic update
+    randomicPhiloxRange(phx->key, phx->stream, atomic_fetch_add_explicit(&phx->pos, n, RANDOMIC_ORDER), out, n);
+}
+RADEF uint32_t randomicPhiloxAt (uint64_t key, uint64_t stream, uint64_t pos) {
+    //returns the value at the given position of the given stream of the given key, as a seeded generator would
+    uint32_t k[2], out;
+    k[0] = (uint32_t)key;
+    k[1] = (uint32_t)(key >> 32);
+    randomicPhiloxRange(k, stream, pos, &out, 1);
+    return out;
+}
+RADEF void randomicAesSeed (struct randomic_aes* aes, uint64_t key, uint64_t stream) {
+    //initializes an aes generator at the start of the given stream, with the 128-bit key mixed from the given one
+    randomicAesExpand(aes->keys, key, randomicMix64(key ^ 0x9e3779b97f4a7c15));
+    aes->stream = stream;
+    atomic_store_explicit(&aes->pos, 0, RANDOMIC_ORDER);
+}
+RADEF void randomicAesSeek (struct randomic_aes* aes, uint64_t pos) {
+    //moves an aes generator to the given position of its stream
+    atomic_store_explicit(&aes->pos, pos, RANDOMIC_ORDER);
+}
+RADEF float randomicAesFloatCO (struct randomic_aes* aes) {
     //returns a random float in the range [0.0, 1.0) (not including 1.0)
-    //provides perfect uniformity but only 2^24 of 2^32 possible values
-    return (float)(randomicNext(rdic) >> 8)/16777216.0f;
+    return randomicToFloatCO(randomicAesNext(aes));
 }
-RADEF float randomicFloatCC (struct randomic* rdic) {
+RADEF float randomicAesFloatCC (struct randomic_aes* aes) {
     //returns a random float in the range [0.0, 1.0] (including 0.0 and 1.0)
-    //uses more of float's available precision at the cost of uniformity
-    return (float)randomicNext(rdic)/(float)UINT32_MAX;
+    return randomicToFloatCC(randomicAesNext(aes));
 }
-RADEF double randomicDoubleCO (struct randomic* rdic) {
+RADEF double randomicAesDoubleCO (struct randomic_aes* aes) {
     //returns a random double in the range [0.0, 1.0) (not including 1.0)
-    //provides perfect uniformity with a full 2^32 possible values
-    return (double)randomicNext(rdic)/4294967296.0;
+    return randomicToDoubleCO(randomicAesNext(aes));
 }
-RADEF double randomicDoubleCC (struct randomic* rdic) {
+RADEF double randomicAesDoubleCC (struct randomic_aes* aes) {
     //returns a random double in the range [0.0, 1.0] (including 0.0 and 1.0)
-    //provides possibly less uniformity as a result of the odd division
-    return (double)randomicNext(rdic)/(double)UINT32_MAX;
+    return randomicToDoubleCC(randomicAesNext(aes));
 }
-RADEF uint32_t randomicNext (struct randomic* rdic) {
+RADEF uint32_t randomicAesNext (struct randomic_aes* aes) {
     //returns a random uint32 (raw output of the generator)
-    struct randomic_ctx ctx = atomic_load(&rdic->ctx), ntx;
-    while (!atomic_compare_exchange_weak(&rdic->ctx, &ctx, (ntx = randomicStep(ctx))));
-    return ntx.d;
+    uint32_t out;
+    randomicAesRange(aes, atomic_fetch_add_explicit(&aes->pos, 1, RANDOMIC_ORDER), &out, 1);
+    return out;
+}
+RADEF void randomicAesFill (struct randomic_aes* aes, uint32_t* out, size_t n) {
+    //writes the next n outputs to out, claimed from the generator with a single atomic update
+    randomicAesRange(aes, atomic_fetch_add_explicit(&aes->pos, n, RANDOMIC_ORDER), out, n);
+}
+RADEF int randomicAesHardware (void) {
+    //returns 1 if aes generators use AES-NI on this machine and 0 if they use the software fallback
+    #ifdef RANDOMIC_AESNI
+        return __builtin_cpu_supports("aes") ? 1 : 0;
+    #else
+        return 0;
+    #endif
+}
+RADEF int randomicChachaSeed (struct randomic_chacha* cha, uint64_t key, uint64_t stream, int rounds) {
+    //initializes a chacha generator with the given number of rounds (8, 12 or 20) at the start of the given stream
+    //returns 0 and leaves the generator untouched for any other number of rounds
+    if (rounds != 8 && rounds != 12 && rounds != 20) return 0;
+    uint64_t k = key;
+    for (int i = 0; i < 8; i += 2) {
+        uint64_t x = randomicMix64(k += 0x9e3779b97f4a7c15);
+        cha->key[i] = (uint32_t)x;
+        cha->key[i + 1] = (uint32_t)(x >> 32);
+    }
+    cha->stream = stream;
+    cha->rounds = rounds;
+    atomic_store_explicit(&cha->pos, 0, RANDOMIC_ORDER);
+    return 1;
+}
+RADEF void randomicChachaSeek (struct randomic_chacha* cha, uint64_t pos) {
+    //moves a chacha generator to the given position of its stream
+    atomic_store_explicit(&cha->pos, pos, RANDOMIC_ORDER);
+}
+RADEF float randomicChachaFloatCO (struct randomic_chacha* cha) {
+    //returns a random float in the range [0.0, 1.0) (not including 1.0)
+    return randomicToFloatCO(randomicChachaNext(cha));
+}
+RADEF float randomicChachaFloatCC (struct randomic_chacha* cha) {
+    //returns a random float in the range [0.0, 1.0] (including 0.0 and 1.0)
+    return randomicToFloatCC(randomicChachaNext(cha));
+}
+RADEF double randomicChachaDoubleCO (struct randomic_chacha* cha) {
+    //returns a random double in the range [0.0, 1.0) (not including 1.0)
+    return randomicToDoubleCO(randomicChachaNext(cha));
+}
+RADEF double randomicChachaDoubleCC (struct randomic_chacha* cha) {
+    //returns a random double in the range [0.0, 1.0] (including 0.0 and 1.0)
+    return randomicToDoubleCC(randomicChachaNext(cha));
+}
+RADEF uint32_t randomicChachaNext (struct randomic_chacha* cha) {
+    //returns a random uint32 (raw output of the generator), which computes a whole block so bulk use should prefer Fill
+    uint32_t out;
+    randomicChachaRange(cha, atomic_fetch_add_explicit(&cha->pos, 1, RANDOMIC_ORDER), &out, 1);
+    return out;
 }
+RADEF void randomicChachaFill (struct randomic_chacha* cha, uint32_t* out, size_t n) {
+    //writes the next n outputs to out, claimed from the generator with a single atomic update
+    randomicChachaRange(cha, atomic_fetch_add_explicit(&cha->pos, n, RANDOMIC_ORDER), out, n);
+}
+#ifdef RANDOMIC_HAS_JUMP
+RADEF void randomicJump (struct randomic* rdic, uint64_t steps) {
+    //advances a generator by the given number of steps, as if randomicNext had been called that many times
+    #ifdef RANDOMIC_XOSHIRO
+        uint32_t m[128][4], v[4];
+        randomicJumpMatrix(m, steps);
+    #endif
+    struct randomic_ctx ctx = randomicLoad(rdic), ntx;
+    do {
+        ntx = ctx;
+        #ifdef RANDOMIC_XOSHIRO
+            memcpy(v, &ctx, sizeof(v));
+            randomicApplyMatrix((const uint32_t (*)[4])m, v, v);
+            memcpy(&ntx, v, sizeof(v));
+        #else
+            randomicJumpLcg(&ntx, steps, 0);
+        #endif
+    } while (!randomicCas(rdic, &ctx, ntx));
+}
+RADEF void randomicLongJump (struct randomic* rdic) {
+    //advances a generator by 2^64 steps (for pcg32 to its next stream instead)
+    struct randomic_ctx ctx = randomicLoad(rdic), ntx;
+    do {
+        ntx = ctx;
+        #if defined(RANDOMIC_XOSHIRO)
+            //xors together the states at the steps given by the jump polynomial
+            const uint32_t jump[4] = {0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b};
+            struct randomic_ctx stx = ctx, jtx = {0, 0, 0, 0};
+            for (int i = 0; i < 128; i++) {
+                if (jump[i/32] >> i%32 & 1)
+                    jtx.a ^= stx.a, jtx.b ^= stx.b, jtx.c ^= stx.c, jtx.d ^= stx.d;
+                randomicStep(&stx);
+            }
+            ntx = jtx;
+        #elif defined(RANDOMIC_PCG)
+            uint64_t inc = ((uint64_t)ctx.c << 32|ctx.d) + 2;
+            ntx.c = (uint32_t)(inc >> 32), ntx.d = (uint32_t)inc;
+        #else
+            randomicJumpLcg(&ntx, 1, 64);
+        #endif
+    } while (!randomicCas(rdic, &ctx, ntx));
+}
+#endif
 
 //internal functions
-static struct randomic_ctx randomicStep (struct randomic_ctx ctx) {
-    //advances the PRNG state by a single step
-    uint32_t e = ctx.a - ((ctx.b << 27)|(ctx.b >> 5));
-    ctx.a = ctx.b ^ ((ctx.c << 17)|(ctx.c >> 15));
-    ctx.b = ctx.c + ctx.d;
-    ctx.c = ctx.d + e;
-    ctx.d = e + ctx.a;
+static void randomicStore (struct randomic* rdic, struct randomic_ctx ctx) {
+    //replaces the state of a generator
+    #ifdef RANDOMIC_LOCK_FREE
+        //starts from a constant guess rather than reading the state, which seeding may not have initialized yet
+        //a wrong guess just makes the first compare and swap fail and return the actual state
+        struct randomic_ctx old = {0, 0, 0, 0};
+        while (!randomicCas(rdic, &old, ctx));
+    #else
+        atomic_store_explicit(&rdic->ctx, ctx, RANDOMIC_ORDER);
+    #endif
+}
+static uint32_t randomicUnstep (struct randomic_ctx* ctx) {
+    //undoes a single step of the PRNG state and returns the output of that step, the inverse of randomicStep
+    #if defined(RANDOMIC_XOSHIRO)
+        //s[1] is recovered from s[1] ^ (s[1] << 9) by the inverse xorshift, after which the rest unwinds directly
+        uint32_t x = (ctx->d >> 11)|(ctx->d << 21), v = ctx->b ^ ctx->c, y;
+        v ^= v << 9 ^ v << 18 ^ v << 27;
+        y = ctx->b ^ v;
+        ctx->a ^= x;
+        ctx->b = v;
+        ctx->c = y ^ ctx->a;
+        ctx->d = x ^ v;
+        v = ctx->a + ctx->d;
+        return ((v << 7)|(v >> 25)) + ctx->a;
+    #elif defined(RANDOMIC_PCG)
+        //subtracts the increment and multiplies by the inverse of the multiplier modulo 2^64
+        uint64_t n = (uint64_t)ctx->a << 32|ctx->b, s = (n - ((uint64_t)ctx->c << 32|ctx->d))*0xc097ef87329e28a5;
+        uint32_t x = (uint32_t)(((s >> 18) ^ s) >> 27), r = (uint32_t)(s >> 59);
+        ctx->a = (uint32_t)(s >> 32);
+        ctx->b = (uint32_t)s;
+        return (x >> r)|(x << (-r & 31));
+    #elif defined(RANDOMIC_LCG128)
+        //subtracts the increment and multiplies by the inverse of the multiplier modulo 2^128
+        uint64_t s[2], mult[2], plus[2], inv[2] = {0x07dda22b93979860, 0x98abc8b0716eac8d}, one[2] = {0, 1};
+        uint32_t out = ctx->a;
+        randomicLcgMap(ctx, s, mult, plus);
+        plus[0] = ~plus[0], plus[1] = ~plus[1];
+        randomicAdd128(s, plus);
+        randomicAdd128(s, one);
+        randomicMul128(s, inv);
+        ctx->a = (uint32_t)(s[0] >> 32), ctx->b = (uint32_t)s[0];
+        ctx->c = (uint32_t)(s[1] >> 32), ctx->d = (uint32_t)s[1];
+        return out;
+    #elif defined(RANDOMIC_ROMU)
+        //w is unwound from the multiplication by its inverse modulo 2^32, the rest by the rotations and subtractions
+        uint32_t z = ctx->a*0x33621f83, w = ctx->b - z, y;
+        w = (w >> 26)|(w << 6);
+        y = ((ctx->d >> 9)|(ctx->d << 23)) - w;
+        ctx->b = y - ctx->c;
+        ctx->a = w, ctx->c = y, ctx->d = z;
+        return ctx->b;
+    #else
+        //e is recovered from the new d and a, after which every word follows from the one recovered before
+        uint32_t out = ctx->d, e = ctx->d - ctx->a;
+        ctx->d = ctx->c - e;
+        ctx->c = ctx->b - ctx->d;
+        ctx->b = ctx->a ^ ((ctx->c << 17)|(ctx->c >> 15));
+        ctx->a = e + ((ctx->b << 27)|(ctx->b >> 5));
+        return out;
+    #endif
+}
+static struct randomic_ctx randomicInit (uint32_t seed) {
+    //returns the state randomicSeed starts warming up from
+    struct randomic_ctx ctx;
+    #if defined(RANDOMIC_XOSHIRO) || defined(RANDOMIC_PCG) || defined(RANDOMIC_ROMU) || defined(RANDOMIC_LCG128)
+        //the seed is spread over the whole state, as the alternative engines take long to recover from sparse states
+        uint64_t x = randomicMix64(0xf1ea5eed00000000|seed), y = randomicMix64(x);
+        ctx.a = (uint32_t)(x >> 32), ctx.b = (uint32_t)x;
+        ctx.c = (uint32_t)(y >> 32), ctx.d = (uint32_t)y;
+        randomicSanitize(&ctx);
+    #else
+        ctx.a = 0xf1ea5eed;
+        ctx.b = ctx.c = ctx.d = seed;
+    #endif
     return ctx;
 }
+static void randomicSanitize (struct randomic_ctx* ctx) {
+    //adjusts a state derived by mixing so that it is valid for the engine
+    #ifdef RANDOMIC_PCG
+        ctx->d |= 1;
+    #else
+        if (!(ctx->a|ctx->b|ctx->c|ctx->d)) ctx->a = 0xf1ea5eed;
+    #endif
+}
+static struct randomic_ctx randomicFork (struct randomic* rdic) {
+    //claims four outputs with a single atomic update and returns a private context mixed from them
+    struct randomic_ctx ctx = randomicLoad(rdic), ntx, ftx;
+    do {
+        ntx = ctx;
+        ftx.a = randomicStep(&ntx);
+        ftx.b = randomicStep(&ntx);
+        ftx.c = randomicStep(&ntx);
+        ftx.d = randomicStep(&ntx);
+    } while (!randomicCas(rdic, &ctx, ntx));
+    return randomicDerive(&ftx, 0);
+}
+static struct randomic_ctx randomicBranch (struct randomic_ctx* ctx) {
+    //randomicFork for a private context
+    struct randomic_ctx btx;
+    btx.a = randomicStep(ctx);
+    btx.b = randomicStep(ctx);
+    btx.c = randomicStep(ctx);
+    btx.d = randomicStep(ctx);
+    return randomicDerive(&btx, 0);
+}
+static struct randomic_ctx randomicDerive (const struct randomic_ctx* ctx, uint64_t id) {
+    //derives the context of stream id from a base context, so that nearby ids give unrelated states
+    //for a fixed base this is a bijection of id (and for a fixed id one of the base), as every step of it is invertible
+    //up to the adjustment for engines with invalid states, which for pcg32 fixes one bit
+    uint64_t x = randomicMix64(((uint64_t)ctx->a << 32|ctx->b) ^ randomicMix64(id + 0x9e3779b97f4a7c15));
+    uint64_t y = randomicMix64(((uint64_t)ctx->c << 32|ctx->d) ^ randomicMix64(x + 0x9e3779b97f4a7c15));
+    struct randomic_ctx dtx;
+    dtx.a = (uint32_t)(x >> 32);
+    dtx.b = (uint32_t)x;
+    dtx.c = (uint32_t)(y >> 32);
+    dtx.d = (uint32_t)y;
+    randomicSanitize(&dtx);
+    return dtx;
+}
+static struct randomic_ctx randomicSpawnCtx (uint64_t seed, uint64_t stream) {
+    //derives the context of a stream of a seed for randomicSpawn
+    //the seed enters both halves of the base, so where two pairs share the first half of the result they differ in the second
+    struct randomic_ctx base;
+    base.a = (uint32_t)(seed >> 32);
+    base.b = (uint32_t)seed;
+    base.c = (uint32_t)seed ^ 0x243f6a88;
+    base.d = (uint32_t)(seed >> 32) ^ 0x85a308d3;
+    return randomicDerive(&base, stream);
+}
+static uint64_t randomicMix64 (uint64_t z) {
+    //splitmix64 finalizer, a bijection where every input bit affects every output bit
+    z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27))*0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+static uint64_t randomicDraw64 (struct randomic_ctx* ctx) {
+    //combines two outputs of a private context into a uint64
+    uint64_t hi = randomicStep(ctx);
+    return hi << 32|randomicStep(ctx);
+}
+static uint32_t randomicDrawBounded (struct randomic_ctx* ctx, uint32_t bound) {
+    //randomicBounded for a private context
+    uint64_t m = (uint64_t)randomicStep(ctx)*bound;
+    if ((uint32_t)m < bound) {
+        uint32_t t = (0u - bound)%bound;
+        while ((uint32_t)m < t)
+            m = (uint64_t)randomicStep(ctx)*bound;
+    }
+    return (uint32_t)(m >> 32);
+}
+static uint64_t randomicDrawBounded64 (struct randomic_ctx* ctx, uint64_t bound) {
+    //randomicBounded for a private context and a uint64 bound, draws two outputs per candidate
+    uint64_t lo, hi = randomicMul64(randomicDraw64(ctx), bound, &lo);
+    if (lo < bound) {
+        uint64_t t = (0u - bound)%bound;
+        while (lo < t)
+            hi = randomicMul64(randomicDraw64(ctx), bound, &lo);
+    }
+    return hi;
+}
+static int randomicDrawBatch (struct randomic_ctx* ctx, uint64_t bound, uint64_t* out) {
+    //draws indices below the decreasing bounds bound, bound-1, ... and returns how many (1 to 4, bounds stay above 1)
+    //a single output serves all bounds whose product fits 32 bits, rejection uses the product like a single bound
+    uint64_t prod = bound;
+    int k = 1;
+    if (bound > UINT32_MAX) {
+        out[0] = randomicDrawBounded64(ctx, bound);
+        return 1;
+    }
+    while (k < 4 && bound - k > 1 && prod*(bound - k) <= UINT32_MAX)
+        prod *= bound - k++;
+    if (k == 1) {
+        out[0] = randomicDrawBounded(ctx, (uint32_t)bound);
+        return 1;
+    }
+    for (uint32_t t = 0;;) {
+        uint32_t l = randomicStep(ctx);
+        for (int m = 0; m < k; m++) {
+            uint64_t x = (uint64_t)l*(bound - m);
+            out[m] = x >> 32;
+            l = (uint32_t)x;
+        }
+        if (l >= prod || l >= (t ? t : (t = (0u - (uint32_t)prod)%(uint32_t)prod)))
+            return k;
+    }
+}
+#if defined(RANDOMIC_PCG) || defined(RANDOMIC_LCG128)
+static void randomicJumpLcg (struct randomic_ctx* ctx, uint64_t steps, int shift) {
+    //advances an lcg-based state by steps*2^shift steps, squaring the affine map of a single step (F. Brown, 1994)
+    uint64_t s[2], mult[2], plus[2], am[2] = {0, 1}, ap[2] = {0, 0};
+    randomicLcgMap(ctx, s, mult, plus);
+    for (int i = 0; steps; i++) {
+        if (i >= shift) {
+            if (steps & 1) {
+                randomicMul128(am, mult);
+                randomicMul128(ap, mult);
+                randomicAdd128(ap, plus);
+            }
+            steps >>= 1;
+        }
+        //the map applied twice is x*mult^2 + plus*(mult + 1)
+        uint64_t t[2] = {mult[0], mult[1]}, one[2] = {0, 1};
+        randomicAdd128(t, one);
+        randomicMul128(plus, t);
+        randomicMul128(mult, mult);
+    }
+    randomicMul128(s, am);
+    randomicAdd128(s, ap);
+    #ifdef RANDOMIC_PCG
+        ctx->a = (uint32_t)(s[1] >> 32), ctx->b = (uint32_t)s[1];
+    #else
+        ctx->a = (uint32_t)(s[0] >> 32), ctx->b = (uint32_t)s[0];
+        ctx->c = (uint32_t)(s[1] >> 32), ctx->d = (uint32_t)s[1];
+    #endif
+}
+#endif
+#ifdef RANDOMIC_XOSHIRO
+static void randomicJumpMatrix (uint32_t (*m)[4], uint64_t steps) {
+    //computes the matrix over GF(2) of the given number of xoshiro steps, with column i as the image of state bit i
+    //the step matrix is squared repeatedly and multiplied in for every set bit of steps
+    uint32_t p[128][4], t[128][4];
+    for (int i = 0; i < 128; i++) {
+        struct randomic_ctx ctx;
+        memset(m[i], 0, sizeof(m[i]));
+        m[i][i/32] = 1u << i%32;
+        memcpy(&ctx, m[i], sizeof(ctx));
+        randomicStep(&ctx);
+        memcpy(p[i], &ctx, sizeof(ctx));
+    }
+    for (; steps; steps >>= 1) {
+        if (steps & 1)
+            for (int i = 0; i < 128; i++) {
+                randomicApplyMatrix((const uint32_t (*)[4])p, m[i], t[i]);
+                memcpy(m[i], t[i], sizeof(t[i]));
+            }
+        if (steps > 1) {
+            for (int i = 0; i < 128; i++)
+                randomicApplyMatrix((const uint32_t (*)[4])p, p[i], t[i]);
+            memcpy(p, t, sizeof(p));
+        }
+    }
+}
+static void randomicApplyMatrix (const uint32_t (*m)[4], const uint32_t* v, uint32_t* out) {
+    //multiplies a GF(2) matrix by a state vector, i.e. xors together the columns of the set bits
+    uint32_t r[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 128; i++) {
+        uint32_t mask = 0u - (v[i/32] >> i%32 & 1);
+        for (int j = 0; j < 4; j++)
+            r[j] ^= m[i][j] & mask;
+    }
+    memcpy(out, r, sizeof(r));
+}
+#endif
+static void randomicSwap (unsigned char* x, unsigned char* y, size_t size) {
+    //swaps two elements of any size through a small buffer, with constant sizes for the common cases
+    unsigned char t[64];
+    if (size == 4) {
+        memcpy(t, x, 4); memcpy(x, y, 4); memcpy(y, t, 4);
+        return;
+    }
+    if (size == 8) {
+        memcpy(t, x, 8); memcpy(x, y, 8); memcpy(y, t, 8);
+        return;
+    }
+    for (size_t s; size; x += s, y += s, size -= s) {
+        s = size < sizeof(t) ? size : sizeof(t);
+        memcpy(t, x, s);
+        memcpy(x, y, s);
+        memcpy(y, t, s);
+    }
+}
+static void randomicShuffleCtx (struct randomic_ctx* ctx, unsigned char* base, size_t n, size_t size) {
+    //fisher-yates shuffle of n elements of the given size using a private context
+    uint64_t js[4];
+    for (size_t i = n; i > 1;)
+        for (int k = randomicDrawBatch(ctx, i, js), m = 0; m < k; m++, i--)
+            randomicSwap(base + (i - 1)*size, base + js[m]*size, size);
+}
+static int randomicScatter (struct randomic_ctx* ctx, unsigned char* src, unsigned char* dst, size_t n, size_t size) {
+    //shuffles n elements from src through dst in buckets, returns 1 if the result ended up in dst and 0 if in src
+    //labels are generated twice from the same context, first to count bucket sizes and then to scatter
+    size_t count[256] = {0}, offset[256], total = 0;
+    int bits = 1, per;
+    //elements larger than half a bucket are shuffled in place too, as buckets of them would never get small enough
+    if (n*size <= RANDOMIC_BUCKET_SIZE || n < 2 || 2*size > RANDOMIC_BUCKET_SIZE) {
+        randomicShuffleCtx(ctx, src, n, size);
+        return 0;
+    }
+    while (bits < 8 && (n*size >> bits) > RANDOMIC_BUCKET_SIZE)
+        bits++;
+    per = 32/bits;
+    struct randomic_ctx lab = randomicBranch(ctx), ltx = lab;
+    uint32_t mask = (1u << bits) - 1, word = 0;
+    for (size_t i = 0; i < n; i++, word >>= bits) {
+        if (i%per == 0) word = randomicStep(&ltx);
+        count[word & mask]++;
+    }
+    for (uint32_t j = 0; j <= mask; total += count[j++])
+        offset[j] = total;
+    ltx = lab;
+    for (size_t i = 0; i < n; i++, word >>= bits) {
+        if (i%per == 0) word = randomicStep(&ltx);
+        unsigned char* to = dst + offset[word & mask]++*size;
+        if (size == 4) memcpy(to, src + i*4, 4);
+        else if (size == 8) memcpy(to, src + i*8, 8);
+        else memcpy(to, src + i*size, size);
+    }
+    //each bucket is shuffled on its own, buckets that recursed back into src are copied over
+    for (uint32_t j = 0; j <= mask; j++) {
+        size_t start = offset[j] - count[j];
+        if (randomicScatter(ctx, dst + start*size, src + start*size, count[j], size))
+            memcpy(dst + start*size, src + start*size, count[j]*size);
+    }
+    return 1;
+}
+static void randomicMerge (struct randomic_ctx* ctx, unsigned char* base, size_t mid, size_t n, size_t size) {
+    //merges the shuffled runs [0, mid) and [mid, n) into one shuffled run (MergeShuffle)
+    //coin flips interleave the runs until one is exhausted, the rest is then inserted at uniform positions
+    size_t i = 0, j = mid;
+    uint32_t bits = 0;
+    for (int left = 0;; left--, bits >>= 1) {
+        if (!left) bits = randomicStep(ctx), left = 32;
+        if (bits & 1) {
+            if (j == n) break;
+            randomicSwap(base + i*size, base + j++*size, size);
+        } else if (i == j) break;
+        i++;
+    }
+    for (; i < n; i++) {
+        uint64_t k = i < UINT32_MAX ? randomicDrawBounded(ctx, (uint32_t)(i + 1)) : randomicDrawBounded64(ctx, i + 1);
+        randomicSwap(base + i*size, base + k*size, size);
+    }
+}
+static size_t randomicBlockStart (size_t n, long blocks, long i) {
+    //returns the first element of block i when splitting n elements into nearly equal blocks
+    size_t rem = n%(size_t)blocks;
+    return n/(size_t)blocks*(size_t)i + ((size_t)i < rem ? (size_t)i : rem);
+}
+static uint64_t randomicFeistel (const struct randomic_perm* perm, uint64_t x) {
+    //one pass of the keyed feistel network over [0, 2^bits), halves trade widths every round
+    int lw = perm->bits/2, rw = perm->bits - lw;
+    uint64_t l = x >> rw, r = x & (((uint64_t)1 << rw) - 1);
+    for (int i = 0; i < 6; i++) {
+        uint64_t t = l ^ (randomicMix64(r ^ perm->keys[i]) & (((uint64_t)1 << lw) - 1));
+        int w = lw;
+        l = r, r = t;
+        lw = rw, rw = w;
+    }
+    return l << rw|r;
+}
+#ifdef RANDOMIC_SAMPLING
+static double randomicDrawOpen (struct randomic_ctx* ctx) {
+    //returns a random double in the open range (0.0, 1.0) with 53 bits, as needed for logarithms
+    return ((double)(randomicDraw64(ctx) >> 11) + 0.5)/9007199254740992.0;
+}
+static uint64_t randomicDrawIndex (struct randomic_ctx* ctx, uint64_t bound) {
+    //randomicBounded for a private context and any bound, with a single output per candidate where possible
+    return bound <= UINT32_MAX ? randomicDrawBounded(ctx, (uint32_t)bound) : randomicDrawBounded64(ctx, bound);
+}
+static uint64_t randomicSkipA (struct randomic_sampler* smp) {
+    //vitter's method A, walks the probability of skipping one more record until it drops below a uniform draw
+    double top = (double)(smp->n - smp->k), rem = (double)smp->n, v, quot;
+    uint64_t s = 0;
+    if (smp->k == 1)
+        return (uint64_t)(rem*randomicDrawOpen(&smp->ctx));
+    v = randomicDrawOpen(&smp->ctx);
+    for (quot = top/rem; quot > v; quot *= top/rem) {
+        s++;
+        top -= 1.0;
+        rem -= 1.0;
+    }
+    return s;
+}
+static uint64_t randomicSkipD (struct randomic_sampler* smp) {
+    //vitter's method D, draws the skip from a continuous approximation and accepts it by rejection
+    //vprime carries a draw for the next call when accepted, fresh tracks whether it matches the current k
+    double kr = (double)smp->k, nr = (double)smp->n, kinv = 1.0/kr, kmin1inv = 1.0/(kr - 1.0);
+    double qu1r = nr - kr + 1.0;
+    uint64_t qu1 = smp->n - smp->k + 1;
+    if (!smp->fresh)
+        smp->vprime = exp(log(randomicDrawOpen(&smp->ctx))*kinv);
+    smp->fresh = 1;
+    if (smp->k == 1)
+        return (uint64_t)(nr*smp->vprime);
+    for (;;) {
+        double x, u, y1, y2 = 1.0, top = nr - 1.0, bottom;
+        uint64_t s, limit;
+        for (;;) {
+            x = nr*(1.0 - smp->vprime);
+            s = (uint64_t)x;
+            if (s < qu1) break;
+            smp->vprime = exp(log(randomicDrawOpen(&smp->ctx))*kinv);
+        }
+        u = randomicDrawOpen(&smp->ctx);
+        y1 = exp(log(u*nr/qu1r)*kmin1inv);
+        smp->vprime = y1*(1.0 - x/nr)*(qu1r/(qu1r - (double)s));
+        if (smp->vprime <= 1.0)
+            return s;
+        if (smp->k - 1 > s) {
+            bottom = nr - kr;
+            limit = smp->n - s;
+        } else {
+            bottom = nr - (double)s - 1.0;
+            limit = qu1;
+        }
+        for (uint64_t t = smp->n - 1; t >= limit; t--) {
+            y2 *= top/bottom;
+            top -= 1.0;
+            bottom -= 1.0;
+        }
+        if (nr/(nr - x) >= y1*exp(log(y2)*kmin1inv)) {
+            smp->vprime = exp(log(randomicDrawOpen(&smp->ctx))*kmin1inv);
+            return s;
+        }
+        smp->vprime = exp(log(randomicDrawOpen(&smp->ctx))*kinv);
+    }
+}
+static int randomicSampleFloyd (struct randomic_ctx* ctx, uint64_t n, uint64_t k, uint64_t* out) {
+    //floyd's algorithm, adds a uniform index below j+1 for every j in [n-k, n), or j itself if already taken
+    //taken indices are tracked in an open addressing hash set with at least twice as many slots, returns 0 if allocation fails
+    size_t slots = 4;
+    while (slots < 2*k)
+        slots *= 2;
+    uint64_t* set = RANDOMIC_MALLOC(slots*sizeof(uint64_t));
+    if (!set) return 0;
+    memset(set, 0, slots*sizeof(uint64_t));
+    for (uint64_t j = n - k, i = 0; j < n; j++, i++) {
+        uint64_t t = randomicDrawIndex(ctx, j + 1), h;
+        for (h = randomicMix64(t) & (slots - 1); set[h] && set[h] != t + 1; h = (h + 1) & (slots - 1));
+        if (set[h]) {
+            t = j;
+            for (h = randomicMix64(t) & (slots - 1); set[h]; h = (h + 1) & (slots - 1));
+        }
+        set[h] = t + 1;
+        out[i] = t;
+    }
+    RANDOMIC_FREE(set);
+    return 1;
+}
+static int randomicSampleDense (struct randomic_ctx* ctx, uint64_t n, uint64_t k, uint64_t* out) {
+    //partial fisher-yates shuffle of the whole range that stops after k elements, returns 0 if allocation fails
+    uint64_t* idx = n <= SIZE_MAX/sizeof(uint64_t) ? RANDOMIC_MALLOC((size_t)n*sizeof(uint64_t)) : NULL;
+    if (!idx) return 0;
+    for (uint64_t i = 0; i < n; i++)
+        idx[i] = i;
+    for (uint64_t i = 0; i < k; i++) {
+        uint64_t j = i + randomicDrawIndex(ctx, n - i);
+        out[i] = idx[j];
+        idx[j] = idx[i];
+    }
+    RANDOMIC_FREE(idx);
+    return 1;
+}
+static void randomicReservoirResume (struct randomic_reservoir* res) {
+    //draws algorithm L's state for a uniform reservoir that has seen res->seen items
+    //this simulates its skips from the start, as the state only needs the right distribution, not the actual history
+    double k = (double)res->k, skip;
+    res->next = res->k ? res->k : UINT64_MAX;
+    if (!res->k) return;
+    res->w = exp(log(randomicDrawOpen(&res->ctx))/k);
+    for (;;) {
+        skip = floor(log(randomicDrawOpen(&res->ctx))/log1p(-res->w));
+        if (skip >= (double)(UINT64_MAX - res->next)) {
+            res->next = UINT64_MAX;
+            return;
+        }
+        res->next += (uint64_t)skip;
+        if (res->next >= res->seen) return;
+        res->next++;
+        res->w *= exp(log(randomicDrawOpen(&res->ctx))/k);
+    }
+}
+static void randomicReservoirPush (struct randomic_reservoir* res, size_t slot, double key) {
+    //adds a slot with the given key to the min-heap of a weighted reservoir
+    size_t i = res->size++;
+    res->keys[slot] = key;
+    for (; i && res->keys[res->heap[(i - 1)/2]] > key; i = (i - 1)/2)
+        res->heap[i] = res->heap[(i - 1)/2];
+    res->heap[i] = slot;
+}
+static void randomicReservoirReplace (struct randomic_reservoir* res, double key) {
+    //gives the slot with the smallest key a new key and restores the min-heap
+    size_t slot = res->heap[0], i = 0;
+    res->keys[slot] = key;
+    for (size_t c; (c = 2*i + 1) < res->size; i = c) {
+        if (c + 1 < res->size && res->keys[res->heap[c + 1]] < res->keys[res->heap[c]]) c++;
+        if (res->keys[res->heap[c]] >= key) break;
+        res->heap[i] = res->heap[c];
+    }
+    res->heap[i] = slot;
+}
+#endif
+static void randomicFillBlock (uint64_t seed, uint64_t block, unsigned char* out, size_t bytes) {
+    //fills up to 64 KiB from the sixteen streams of a block, interleaving their outputs
+    uint32_t a[16], b[16], c[16], d[16], vals[16];
+    for (int j = 0; j < 16; j++) {
+        struct randomic_ctx ctx = randomicSpawnCtx(seed, 16*block + (uint64_t)j);
+        a[j] = ctx.a, b[j] = ctx.b, c[j] = ctx.c, d[j] = ctx.d;
+    }
+    for (size_t i = 0; i < bytes; i += sizeof(vals)) {
+        randomicStepLanes(a, b, c, d, vals, 16);
+        memcpy(out + i, vals, bytes - i < sizeof(vals) ? bytes - i : sizeof(vals));
+    }
+}
+static void randomicPhiloxBlock (const uint32_t* key, uint64_t block, uint64_t stream, uint32_t* out) {
+    //encrypts the counter of a single block, writing its four values to out
+    uint32_t c0 = (uint32_t)block, c1 = (uint32_t)(block >> 32), c2 = (uint32_t)stream, c3 = (uint32_t)(stream >> 32);
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int r = 0; r < 10; r++, k0 += 0x9e3779b9, k1 += 0xbb67ae85) {
+        uint64_t p0 = (uint64_t)0xd2511f53*c0, p1 = (uint64_t)0xcd9e8d57*c2;
+        c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t)p1;
+        c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t)p0;
+    }
+    out[0] = c0, out[1] = c1, out[2] = c2, out[3] = c3;
+}
+static void randomicPhiloxBlocks (const uint32_t* key, uint64_t block, uint64_t stream, uint32_t* out) {
+    //encrypts the counters of eight consecutive blocks, writing their 32 values to out
+    #ifdef __AVX2__
+        //each vector holds one counter word of all eight blocks, the even and odd lanes are multiplied separately
+        uint32_t lo[8], hi[8], w[4][8];
+        for (int i = 0; i < 8; i++)
+            lo[i] = (uint32_t)(block + i), hi[i] = (uint32_t)((block + i) >> 32);
+        __m256i c0 = _mm256_loadu_si256((const __m256i*)lo), c1 = _mm256_loadu_si256((const __m256i*)hi);
+        __m256i c2 = _mm256_set1_epi32((int)(uint32_t)stream), c3 = _mm256_set1_epi32((int)(uint32_t)(stream >> 32));
+        __m256i m0 = _mm256_set1_epi32((int)0xd2511f53), m1 = _mm256_set1_epi32((int)0xcd9e8d57);
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int r = 0; r < 10; r++, k0 += 0x9e3779b9, k1 += 0xbb67ae85) {
+            __m256i e0 = _mm256_mul_epu32(c0, m0), o0 = _mm256_mul_epu32(_mm256_srli_epi64(c0, 32), m0);
+            __m256i e1 = _mm256_mul_epu32(c2, m1), o1 = _mm256_mul_epu32(_mm256_srli_epi64(c2, 32), m1);
+            __m256i lo0 = _mm256_blend_epi32(e0, _mm256_slli_epi64(o0, 32), 0xaa);
+            __m256i hi0 = _mm256_blend_epi32(_mm256_srli_epi64(e0, 32), o0, 0xaa);
+            __m256i lo1 = _mm256_blend_epi32(e1, _mm256_slli_epi64(o1, 32), 0xaa);
+            __m256i hi1 = _mm256_blend_epi32(_mm256_srli_epi64(e1, 32), o1, 0xaa);
+            c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32((int)k0));
+            c1 = lo1;
+            c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32((int)k1));
+            c3 = lo0;
+        }
+        _mm256_storeu_si256((__m256i*)w[0], c0);
+        _mm256_storeu_si256((__m256i*)w[1], c1);
+        _mm256_storeu_si256((__m256i*)w[2], c2);
+        _mm256_storeu_si256((__m256i*)w[3], c3);
+        for (int i = 0; i < 8; i++)
+            out[4*i] = w[0][i], out[4*i + 1] = w[1][i], out[4*i + 2] = w[2][i], out[4*i + 3] = w[3][i];
+    #else
+        for (int i = 0; i < 8; i++)
+            randomicPhiloxBlock(key, block + i, stream, out + 4*i);
+    #endif
+}
+static void randomicPhiloxRange (const uint32_t* key, uint64_t stream, uint64_t pos, uint32_t* out, size_t n) {
+    //writes the n values of a stream starting at the given position to out, whole groups of eight blocks go through the simd path
+    while (n) {
+        uint32_t w[4];
+        size_t m = 4 - pos%4;
+        if (pos%4 == 0 && n >= 32) {
+            randomicPhiloxBlocks(key, pos/4, stream, out);
+            out += 32, pos += 32, n -= 32;
+            continue;
+        }
+        randomicPhiloxBlock(key, pos/4, stream, w);
+        if (m > n) m = n;
+        memcpy(out, w + pos%4, m*sizeof(uint32_t));
+        out += m, pos += m, n -= m;
+    }
+}
+static const uint8_t randomicAesSbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+static void randomicAesExpand (uint8_t* rk, uint64_t lo, uint64_t hi) {
+    //expands the 128-bit key (lo first, both little endian) into the eleven round keys of AES-128
+    uint8_t rcon = 1;
+    for (int i = 0; i < 8; i++)
+        rk[i] = (uint8_t)(lo >> 8*i), rk[i + 8] = (uint8_t)(hi >> 8*i);
+    for (int i = 16; i < 176; i += 4) {
+        uint8_t t0 = rk[i - 4], t1 = rk[i - 3], t2 = rk[i - 2], t3 = rk[i - 1];
+        if (i%16 == 0) {
+            uint8_t u = t0;
+            t0 = randomicAesSbox[t1] ^ rcon;
+            t1 = randomicAesSbox[t2];
+            t2 = randomicAesSbox[t3];
+            t3 = randomicAesSbox[u];
+            rcon = (uint8_t)(rcon << 1 ^ (rcon >> 7)*0x1b);
+        }
+        rk[i] = rk[i - 16] ^ t0, rk[i + 1] = rk[i - 15] ^ t1;
+        rk[i + 2] = rk[i - 14] ^ t2, rk[i + 3] = rk[i - 13] ^ t3;
+    }
+}
+static uint8_t randomicAesXtime (uint8_t v) {
+    //multiplies by x in AES's finite field
+    return (uint8_t)(v << 1 ^ (v >> 7)*0x1b);
+}
+static void randomicAesSoft (const uint8_t* rk, uint64_t block, uint64_t stream, uint32_t* out) {
+    //encrypts the counter of a single block in software, writing its four values to out
+    uint8_t s[16], t[16];
+    for (int i = 0; i < 8; i++)
+        s[i] = (uint8_t)(block >> 8*i) ^ rk[i], s[i + 8] = (uint8_t)(stream >> 8*i) ^ rk[i + 8];
+    for (int r = 1; r <= 10; r++) {
+        //subbytes and shiftrows, then mixcolumns except in the last round, then the round key
+        for (int i = 0; i < 16; i++)
+            t[i] = randomicAesSbox[s[(i + 4*(i%4))%16]];
+        for (int c = 0; c < 16 && r < 10; c += 4) {
+            uint8_t a0 = t[c], a1 = t[c + 1], a2 = t[c + 2], a3 = t[c + 3], x = a0 ^ a1 ^ a2 ^ a3;
+            t[c] = a0 ^ x ^ randomicAesXtime(a0 ^ a1);
+            t[c + 1] = a1 ^ x ^ randomicAesXtime(a1 ^ a2);
+            t[c + 2] = a2 ^ x ^ randomicAesXtime(a2 ^ a3);
+            t[c + 3] = a3 ^ x ^ randomicAesXtime(a3 ^ a0);
+        }
+        for (int i = 0; i < 16; i++)
+            s[i] = t[i] ^ rk[16*r + i];
+    }
+    for (int i = 0; i < 4; i++)
+        out[i] = (uint32_t)s[4*i]|(uint32_t)s[4*i + 1] << 8|(uint32_t)s[4*i + 2] << 16|(uint32_t)s[4*i + 3] << 24;
+}
+#ifdef RANDOMIC_AESNI
+__attribute__((target("aes,sse2")))
+static void randomicAesNI (const uint8_t* rk, uint64_t block, uint64_t stream, uint32_t* out, size_t blocks) {
+    //encrypts the counters of consecutive blocks with AES-NI, eight at a time to hide the latency of aesenc
+    __m128i k[11];
+    for (int r = 0; r < 11; r++)
+        k[r] = _mm_loadu_si128((const __m128i*)(rk + 16*r));
+    for (; blocks; ) {
+        __m128i b[8];
+        size_t m = blocks < 8 ? blocks : 8;
+        for (size_t i = 0; i < m; i++)
+            b[i] = _mm_xor_si128(_mm_set_epi64x((long long)stream, (long long)(block + i)), k[0]);
+        for (int r = 1; r < 10; r++)
+            for (size_t i = 0; i < m; i++)
+                b[i] = _mm_aesenc_si128(b[i], k[r]);
+        for (size_t i = 0; i < m; i++)
+            _mm_storeu_si128((__m128i*)(out + 4*i), _mm_aesenclast_si128(b[i], k[10]));
+        block += m, out += 4*m, blocks -= m;
+    }
+}
+#endif
+static void randomicAesRange (const struct randomic_aes* aes, uint64_t pos, uint32_t* out, size_t n) {
+    //writes the n values of a stream starting at the given position to out, whole blocks are encrypted in place
+    int hw = randomicAesHardware();
+    while (n) {
+        uint32_t w[4];
+        size_t m = 4 - pos%4;
+        #ifdef RANDOMIC_AESNI
+            if (hw && pos%4 == 0 && n >= 4) {
+                randomicAesNI(aes->keys, pos/4, aes->stream, out, n/4);
+                out += n/4*4, pos += n/4*4, n %= 4;
+                continue;
+            }
+            if (hw) randomicAesNI(aes->keys, pos/4, aes->stream, w, 1);
+            else randomicAesSoft(aes->keys, pos/4, aes->stream, w);
+        #else
+            (void)hw;
+            randomicAesSoft(aes->keys, pos/4, aes->stream, w);
+        #endif
+        if (m > n) m = n;
+        memcpy(out, w + pos%4, m*sizeof(uint32_t));
+        out += m, pos += m, n -= m;
+    }
+}
+static void randomicChachaBlock (const struct randomic_chacha* cha, uint64_t block, uint32_t* out) {
+    //computes a single block, writing its sixteen values to out
+    uint32_t x[16], in[16] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+    memcpy(in + 4, cha->key, sizeof(cha->key));
+    in[12] = (uint32_t)block, in[13] = (uint32_t)(block >> 32);
+    in[14] = (uint32_t)cha->stream, in[15] = (uint32_t)(cha->stream >> 32);
+    memcpy(x, in, sizeof(x));
+    for (int r = 0; r < cha->rounds; r += 2)
+        for (int i = 0; i < 8; i++) {
+            //four column quarter rounds followed by four diagonal ones
+            int a = i%4, b = 4 + (i < 4 ? i : (i + 1)%4), c = 8 + (i < 4 ? i : (i + 2)%4), d = 12 + (i < 4 ? i : (i + 3)%4);
+            x[a] += x[b], x[d] ^= x[a], x[d] = x[d] << 16|x[d] >> 16;
+            x[c] += x[d], x[b] ^= x[c], x[b] = x[b] << 12|x[b] >> 20;
+            x[a] += x[b], x[d] ^= x[a], x[d] = x[d] << 8|x[d] >> 24;
+            x[c] += x[d], x[b] ^= x[c], x[b] = x[b] << 7|x[b] >> 25;
+        }
+    for (int i = 0; i < 16; i++)
+        out[i] = x[i] + in[i];
+}
+static void randomicChachaBlocks (const struct randomic_chacha* cha, uint64_t block, uint32_t* out) {
+    //computes eight consecutive blocks, writing their 128 values to out
+    #ifdef __AVX2__
+        //each vector holds one state word of all eight blocks, so the quarter rounds work on whole vectors
+        #ifdef __AVX512VL__
+            #define RANDOMIC_ROTL(v, n) _mm256_rol_epi32(v, n)
+        #else
+            #define RANDOMIC_ROTL(v, n) ((n) == 16 ? _mm256_shuffle_epi8(v, rot16) : (n) == 8 ? _mm256_shuffle_epi8(v, rot8) :\
+                _mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32 - (n))))
+            const __m256i rot16 = _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+                13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+            const __m256i rot8 = _mm256_set_epi8(14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+                14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3);
+        #endif
+        uint32_t lo[8], hi[8], w[16][8];
+        __m256i x[16], in[16];
+        for (int i = 0; i < 8; i++)
+            lo[i] = (uint32_t)(block + i), hi[i] = (uint32_t)((block + i) >> 32);
+        in[0] = _mm256_set1_epi32(0x61707865), in[1] = _mm256_set1_epi32(0x3320646e);
+        in[2] = _mm256_set1_epi32(0x79622d32), in[3] = _mm256_set1_epi32(0x6b206574);
+        for (int i = 0; i < 8; i++)
+            in[4 + i] = _mm256_set1_epi32((int)cha->key[i]);
+        in[12] = _mm256_loadu_si256((const __m256i*)lo), in[13] = _mm256_loadu_si256((const __m256i*)hi);
+        in[14] = _mm256_set1_epi32((int)(uint32_t)cha->stream), in[15] = _mm256_set1_epi32((int)(uint32_t)(cha->stream >> 32));
+        for (int i = 0; i < 16; i++)
+            x[i] = in[i];
+        for (int r = 0; r < cha->rounds; r += 2)
+            for (int i = 0; i < 8; i++) {
+                int a = i%4, b = 4 + (i < 4 ? i : (i + 1)%4), c = 8 + (i < 4 ? i : (i + 2)%4), d = 12 + (i < 4 ? i : (i + 3)%4);
+                x[a] = _mm256_add_epi32(x[a], x[b]), x[d] = RANDOMIC_ROTL(_mm256_xor_si256(x[d], x[a]), 16);
+                x[c] = _mm256_add_epi32(x[c], x[d]), x[b] = RANDOMIC_ROTL(_mm256_xor_si256(x[b], x[c]), 12);
+                x[a] = _mm256_add_epi32(x[a], x[b]), x[d] = RANDOMIC_ROTL(_mm256_xor_si256(x[d], x[a]), 8);
+                x[c] = _mm256_add_epi32(x[c], x[d]), x[b] = RANDOMIC_ROTL(_mm256_xor_si256(x[b], x[c]), 7);
+            }
+        #undef RANDOMIC_ROTL
+        for (int i = 0; i < 16; i++)
+            _mm256_storeu_si256((__m256i*)w[i], _mm256_add_epi32(x[i], in[i]));
+        for (int j = 0; j < 8; j++)
+            for (int i = 0; i < 16; i++)
+                out[16*j + i] = w[i][j];
+    #else
+        for (int i = 0; i < 8; i++)
+            randomicChachaBlock(cha, block + i, out + 16*i);
+    #endif
+}
+static void randomicChachaRange (const struct randomic_chacha* cha, uint64_t pos, uint32_t* out, size_t n) {
+    //writes the n values of a stream starting at the given position to out, whole groups of eight blocks go through the simd path
+    while (n) {
+        uint32_t w[16];
+        size_t m = 16 - pos%16;
+        if (pos%16 == 0 && n >= 128) {
+            randomicChachaBlocks(cha, pos/16, out);
+            out += 128, pos += 128, n -= 128;
+            continue;
+        }
+        randomicChachaBlock(cha, pos/16, w);
+        if (m > n) m = n;
+        memcpy(out, w + pos%16, m*sizeof(uint32_t));
+        out += m, pos += m, n -= m;
+    }
+}
 
 #endif //RANDOMIC_IMPLEMENTATION
 #endif //RANDOMIC_H
\ No newline at end of file
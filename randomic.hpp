@@ -0,0 +1,485 @@
+/*
+randomic.hpp - C++ port of the randomic.h generators, for use with the standard library's random number facilities
+
+To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring
+rights to this software to the public domain worldwide. This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with this software.
+If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/*
+randomic.hpp supports the same engine definitions as randomic.h:
+#define RANDOMIC_XOSHIRO
+#define RANDOMIC_PCG
+#define RANDOMIC_ROMU
+#define RANDOMIC_LCG128
+    Replaces smallprng with the same engine as in randomic.h, the generators produce the same values as the C version if
+    both are compiled with the same definition.
+#define RANDOMIC_RELAXED
+    Updates randomic::atomic_engine with relaxed rather than sequentially consistent atomics, like randomic.h does.
+
+randomic.hpp usage:
+    randomic::engine is a non-atomic generator and randomic::atomic_engine one that can be shared between threads like struct
+    randomic. Both meet the UniformRandomBitGenerator requirements, so they can be passed to the <random> distributions or
+    std::shuffle, with operator() returning the same values as randomicNext. They are constructed from a seed like randomicSeed,
+    or by the static spawn(seed, stream) like randomicSpawn, and split() returns a randomic::engine seeded like randomicSplit.
+    float_co, float_cc, double_co and double_cc map the next value like randomicFloatCO/CC and randomicDoubleCO/CC do, discard
+    skips values and generate(first, last) fills a range with consecutive values. Copying an atomic_engine copies a snapshot
+    of its state.
+    randomic::engine is a literal type and all its members are constexpr, so it can generate values at compile time, e.g.
+    constexpr auto table = randomic::make_table<uint64_t, 4096>(seed), where make_table (C++17) returns a std::array of
+    unsigned values drawn from the generator seeded like randomicSeed, or from a given engine.
+    randomic::views::uniform<T>(rng) (C++20) is an infinite view over uniform values of type T from an engine or atomic_engine,
+    with T being std::uint32_t for the plain outputs, or float or double for values in [0, 1) like randomicFloatCO and
+    randomicDoubleCO, e.g. for (float x : randomic::views::uniform<float>(rng) | std::views::take(n)). randomic::generate<T>(rng)
+    returns the same values as a randomic::generator<T> coroutine.
+
+randomic.hpp details:
+    Requires C++14. The C header can't be included from C++, as its atomics are C11 ones, so the engines are ported rather than
+    wrapped, with the same state layout and arithmetic. atomic_engine::generate claims all its values with a single compare and
+    swap, rather than one per value as a loop calling operator() would, and thus needs a forward iterator. atomic_engine uses
+    std::atomic on 16 bytes, which like C11 atomics may need -latomic and may not be lock-free (see is_lock_free), as the inline
+    assembly of randomic.h is not ported.
+    make_table fills 8-byte values from two outputs drawn one after the other, the first one in the high half (the order in
+    which randomicPermInit draws its keys), and smaller values from the low bits of one output, so a table equals the values
+    a C loop would draw. Large tables may exceed the compiler's limits on constant evaluation, which GCC raises with
+    -fconstexpr-loop-limit and -fconstexpr-ops-limit.
+    views::uniform and generate draw blocks of 256 values with generate, which for atomic_engine means a single atomic update
+    per block, and map them in a separate loop, so the only work left per element is reading the block. Thus the generator
+    advances in whole blocks, and the values after the last one taken from a block are skipped. The block is held by the
+    iterator and the view only refers to the engine, so views can be moved or copied freely, even while being iterated, and
+    a copied iterator continues with its own copy of the block. generator is a minimal
+    std::generator (which is C++23) for infinite sequences, resuming the coroutine for every value, so views::uniform is
+    usually faster, see randomic_bench.cpp for both compared to loops.
+*/
+
+//include only once
+#ifndef RANDOMIC_HPP
+#define RANDOMIC_HPP
+
+//process configuration
+#if defined(RANDOMIC_XOSHIRO) + defined(RANDOMIC_PCG) + defined(RANDOMIC_ROMU) + defined(RANDOMIC_LCG128) > 1
+    #error "randomic: at most one of RANDOMIC_XOSHIRO, RANDOMIC_PCG, RANDOMIC_ROMU and RANDOMIC_LCG128 may be defined"
+#endif
+
+//includes
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#if __cplusplus >= 202002L
+    #include <random>
+    #include <ranges>
+    #ifdef __cpp_impl_coroutine
+        #include <coroutine>
+        #include <exception>
+        #include <utility>
+    #endif
+#endif
+
+namespace randomic {
+
+//internal functions
+namespace detail {
+    struct ctx {
+        std::uint32_t a, b, c, d;
+    };
+    constexpr std::uint32_t rotl (std::uint32_t x, int k) noexcept {
+        //rotates left by 0 < k < 32 bits
+        return (x << k)|(x >> (32 - k));
+    }
+    constexpr std::uint64_t mix64 (std::uint64_t z) noexcept {
+        //splitmix64 finalizer, like randomicMix64
+        z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27))*0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+    constexpr std::uint64_t mul64 (std::uint64_t x, std::uint64_t y, std::uint64_t& lo) noexcept {
+        //full 64x64 bit multiplication, returns the high half and stores the low half
+        #ifdef __SIZEOF_INT128__
+            __extension__ unsigned __int128 m = (unsigned __int128)x*y;
+            lo = (std::uint64_t)m;
+            return (std::uint64_t)(m >> 64);
+        #else
+            std::uint64_t ll = (x & 0xffffffff)*(y & 0xffffffff), lh = (x & 0xffffffff)*(y >> 32);
+            std::uint64_t hl = (x >> 32)*(y & 0xffffffff), hh = (x >> 32)*(y >> 32);
+            std::uint64_t mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+            lo = mid << 32|(ll & 0xffffffff);
+            return hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+        #endif
+    }
+    constexpr std::uint32_t step (ctx& s) noexcept {
+        //advances the state by a single step and returns its output, like randomicStep
+        #if defined(RANDOMIC_XOSHIRO)
+            std::uint32_t r = s.a + s.d, t = s.b << 9, out = rotl(r, 7) + s.a;
+            s.c ^= s.a;
+            s.d ^= s.b;
+            s.b ^= s.c;
+            s.a ^= s.d;
+            s.c ^= t;
+            s.d = rotl(s.d, 11);
+            return out;
+        #elif defined(RANDOMIC_PCG)
+            std::uint64_t o = (std::uint64_t)s.a << 32|s.b, n = o*6364136223846793005u + ((std::uint64_t)s.c << 32|s.d);
+            std::uint32_t x = (std::uint32_t)(((o >> 18) ^ o) >> 27), r = (std::uint32_t)(o >> 59);
+            s.a = (std::uint32_t)(n >> 32);
+            s.b = (std::uint32_t)n;
+            return (x >> r)|(x << (-r & 31));
+        #elif defined(RANDOMIC_LCG128)
+            std::uint64_t hi = (std::uint64_t)s.a << 32|s.b, lo = (std::uint64_t)s.c << 32|s.d, l = 0;
+            std::uint64_t h = mul64(lo, 0x4385df649fccf645, l) + hi*0x4385df649fccf645 + lo*0x2360ed051fc65da4;
+            l += 0x14057b7ef767814f;
+            h += 0x5851f42d4c957f2d + (l < 0x14057b7ef767814f);
+            s.a = (std::uint32_t)(h >> 32), s.b = (std::uint32_t)h;
+            s.c = (std::uint32_t)(l >> 32), s.d = (std::uint32_t)l;
+            return s.a;
+        #elif defined(RANDOMIC_ROMU)
+            std::uint32_t w = s.a, x = s.b;
+            s.a = 3323815723u*s.d;
+            s.b = s.d + rotl(w, 26);
+            s.d = rotl(s.c + w, 9);
+            s.c -= x;
+            return x;
+        #else
+            std::uint32_t e = s.a - rotl(s.b, 27);
+            s.a = s.b ^ rotl(s.c, 17);
+            s.b = s.c + s.d;
+            s.c = s.d + e;
+            s.d = e + s.a;
+            return s.d;
+        #endif
+    }
+    constexpr void sanitize (ctx& s) noexcept {
+        //adjusts a state derived by mixing so that it is valid for the engine, like randomicSanitize
+        #ifdef RANDOMIC_PCG
+            s.d |= 1;
+        #else
+            if (!(s.a|s.b|s.c|s.d)) s.a = 0xf1ea5eed;
+        #endif
+    }
+    constexpr ctx seed (std::uint32_t seed) noexcept {
+        //returns the state randomicSeed sets, including the warm-up
+        ctx s{0xf1ea5eed, seed, seed, seed};
+        #if defined(RANDOMIC_XOSHIRO) || defined(RANDOMIC_PCG) || defined(RANDOMIC_ROMU) || defined(RANDOMIC_LCG128)
+            std::uint64_t x = mix64(0xf1ea5eed00000000|seed), y = mix64(x);
+            s = ctx{(std::uint32_t)(x >> 32), (std::uint32_t)x, (std::uint32_t)(y >> 32), (std::uint32_t)y};
+            sanitize(s);
+        #endif
+        for (int i = 0; i < 20; i++)
+            step(s);
+        return s;
+    }
+    constexpr ctx derive (const ctx& s, std::uint64_t id) noexcept {
+        //derives the state of stream id from a base state, like randomicDerive
+        std::uint64_t x = mix64(((std::uint64_t)s.a << 32|s.b) ^ mix64(id + 0x9e3779b97f4a7c15));
+        std::uint64_t y = mix64(((std::uint64_t)s.c << 32|s.d) ^ mix64(x + 0x9e3779b97f4a7c15));
+        ctx d{(std::uint32_t)(x >> 32), (std::uint32_t)x, (std::uint32_t)(y >> 32), (std::uint32_t)y};
+        sanitize(d);
+        return d;
+    }
+    constexpr ctx spawn (std::uint64_t seed, std::uint64_t stream) noexcept {
+        //returns the state randomicSpawn sets
+        ctx base{(std::uint32_t)(seed >> 32), (std::uint32_t)seed, (std::uint32_t)seed ^ 0x243f6a88,
+            (std::uint32_t)(seed >> 32) ^ 0x85a308d3};
+        return derive(base, stream);
+    }
+    constexpr ctx branch (ctx& s) noexcept {
+        //takes four outputs and mixes them into a new state, like randomicBranch
+        ctx b{};
+        b.a = step(s);
+        b.b = step(s);
+        b.c = step(s);
+        b.d = step(s);
+        return derive(b, 0);
+    }
+}
+
+//engines
+class engine {
+public:
+    using result_type = std::uint32_t;
+    static constexpr result_type min () noexcept { return 0; }
+    static constexpr result_type max () noexcept { return UINT32_MAX; }
+    constexpr explicit engine (std::uint32_t seed = 0) noexcept : state(detail::seed(seed)) {}
+    static constexpr engine spawn (std::uint64_t seed, std::uint64_t stream) noexcept {
+        //returns the generator of the given stream of a seed, like randomicSpawn
+        return engine(detail::spawn(seed, stream));
+    }
+    constexpr void seed (std::uint32_t seed) noexcept {
+        //reseeds the generator like randomicSeed
+        state = detail::seed(seed);
+    }
+    constexpr result_type operator() () noexcept {
+        //returns the next value, like randomicNext
+        return detail::step(state);
+    }
+    constexpr float float_co () noexcept { return (float)(detail::step(state) >> 8)/16777216.0f; }
+    constexpr float float_cc () noexcept { return (float)detail::step(state)/(float)UINT32_MAX; }
+    constexpr double double_co () noexcept { return (double)detail::step(state)/4294967296.0; }
+    constexpr double double_cc () noexcept { return (double)detail::step(state)/(double)UINT32_MAX; }
+    constexpr void discard (unsigned long long n) noexcept {
+        //skips the next n values
+        for (; n; n--)
+            detail::step(state);
+    }
+    template <class It, class Sentinel> constexpr void generate (It first, Sentinel last) {
+        //fills a range with the next values, stepping a local copy of the state
+        detail::ctx s = state;
+        for (; first != last; ++first)
+            *first = detail::step(s);
+        state = s;
+    }
+    constexpr engine split () noexcept {
+        //returns a generator seeded from four values of this one, like randomicSplit
+        return engine(detail::branch(state));
+    }
+    friend constexpr bool operator== (const engine& x, const engine& y) noexcept {
+        return x.state.a == y.state.a && x.state.b == y.state.b && x.state.c == y.state.c && x.state.d == y.state.d;
+    }
+    friend constexpr bool operator!= (const engine& x, const engine& y) noexcept { return !(x == y); }
+private:
+    friend class atomic_engine;
+    constexpr explicit engine (const detail::ctx& s) noexcept : state(s) {}
+    detail::ctx state;
+};
+class atomic_engine {
+public:
+    using result_type = std::uint32_t;
+    static constexpr result_type min () noexcept { return 0; }
+    static constexpr result_type max () noexcept { return UINT32_MAX; }
+    explicit atomic_engine (std::uint32_t seed = 0) noexcept : state(detail::seed(seed)) {}
+    atomic_engine (const atomic_engine& other) noexcept : state(other.state.load(order)) {}
+    atomic_engine& operator= (const atomic_engine& other) noexcept {
+        //copies a snapshot of the other generator's state
+        state.store(other.state.load(order), order);
+        return *this;
+    }
+    static atomic_engine spawn (std::uint64_t seed, std::uint64_t stream) noexcept {
+        //returns the generator of the given stream of a seed, like randomicSpawn
+        return atomic_engine(detail::spawn(seed, stream));
+    }
+    void seed (std::uint32_t seed) noexcept {
+        //reseeds the generator like randomicSeed
+        state.store(detail::seed(seed), order);
+    }
+    result_type operator() () noexcept {
+        //returns the next value with a single atomic update, like randomicNext
+        detail::ctx s = state.load(order), n{};
+        result_type out;
+        do {
+            n = s;
+            out = detail::step(n);
+        } while (!state.compare_exchange_weak(s, n, order, order));
+        return out;
+    }
+    float float_co () noexcept { return (float)((*this)() >> 8)/16777216.0f; }
+    float float_cc () noexcept { return (float)(*this)()/(float)UINT32_MAX; }
+    double double_co () noexcept { return (double)(*this)()/4294967296.0; }
+    double double_cc () noexcept { return (double)(*this)()/(double)UINT32_MAX; }
+    void discard (unsigned long long n) noexcept {
+        //skips the next n values with a single atomic update
+        detail::ctx s = state.load(order), t{};
+        do {
+            t = s;
+            for (unsigned long long i = 0; i < n; i++)
+                detail::step(t);
+        } while (!state.compare_exchange_weak(s, t, order, order));
+    }
+    template <class It, class Sentinel> void generate (It first, Sentinel last) {
+        //fills a range with the next values, claimed with a single atomic update (refilled if that fails)
+        detail::ctx s = state.load(order), t{};
+        do {
+            t = s;
+            for (It i = first; i != last; ++i)
+                *i = detail::step(t);
+        } while (!state.compare_exchange_weak(s, t, order, order));
+    }
+    engine split () noexcept {
+        //returns a generator seeded from four values claimed with a single atomic update, like randomicSplit
+        detail::ctx s = state.load(order), t{}, b{};
+        do {
+            t = s;
+            b = detail::branch(t);
+        } while (!state.compare_exchange_weak(s, t, order, order));
+        return engine(b);
+    }
+    bool is_lock_free () const noexcept { return state.is_lock_free(); }
+private:
+    explicit atomic_engine (const detail::ctx& s) noexcept : state(s) {}
+    #ifdef RANDOMIC_RELAXED
+        static constexpr std::memory_order order = std::memory_order_relaxed;
+    #else
+        static constexpr std::memory_order order = std::memory_order_seq_cst;
+    #endif
+    std::atomic<detail::ctx> state;
+};
+
+//compile-time tables
+#if __cplusplus >= 201703L
+    template <class T, std::size_t N> constexpr std::array<T, N> make_table (engine rng) noexcept {
+        //returns N values drawn from a copy of the generator
+        static_assert(std::is_unsigned<T>::value && sizeof(T) <= 8, "T must be an unsigned integer type of up to 64 bits");
+        std::array<T, N> table{};
+        for (std::size_t i = 0; i < N; i++)
+            if (sizeof(T) > 4) {
+                std::uint64_t hi = rng();
+                table[i] = (T)(hi << 32|rng());
+            } else table[i] = (T)rng();
+        return table;
+    }
+    template <class T, std::size_t N> constexpr std::array<T, N> make_table (std::uint32_t seed) noexcept {
+        //returns N values drawn from a generator seeded like randomicSeed
+        return make_table<T, N>(engine(seed));
+    }
+#endif
+#if __cplusplus >= 202002L
+    static_assert(std::uniform_random_bit_generator<engine>);
+    static_assert(std::uniform_random_bit_generator<atomic_engine>);
+#endif
+
+//ranges
+#if __cplusplus >= 202002L && defined(__cpp_lib_ranges)
+    namespace detail {
+        inline constexpr std::size_t block_size = 256;
+        template <class T> void map_block (const std::uint32_t* raw, std::array<T, block_size>& block) noexcept {
+            //maps a block of outputs to T in a loop of its own, which the compiler can vectorize
+            static_assert(std::is_same_v<T, std::uint32_t> || std::is_same_v<T, float> || std::is_same_v<T, double>,
+                "T must be std::uint32_t, float or double");
+            for (std::size_t i = 0; i < block_size; i++)
+                if constexpr (std::is_same_v<T, float>) block[i] = (float)(raw[i] >> 8)/16777216.0f;
+                else if constexpr (std::is_same_v<T, double>) block[i] = (double)raw[i]/4294967296.0;
+                else block[i] = raw[i];
+        }
+        template <class T, class Engine> void fill_block (Engine& rng, std::array<T, block_size>& block) {
+            //draws a block with a single bulk call and maps it to T
+            std::uint32_t raw[block_size];
+            rng.generate(raw, raw + block_size);
+            map_block(raw, block);
+        }
+    }
+    namespace views {
+        template <class T, class Engine> class uniform_view : public std::ranges::view_interface<uniform_view<T, Engine>> {
+        public:
+            class iterator {
+            public:
+                using iterator_concept = std::input_iterator_tag;
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+                iterator () = default;
+                explicit iterator (Engine* rng) : rng(rng) { refill(); }
+                iterator (const iterator& other) noexcept : rng(other.rng), block(other.block), cur(at(other)) {}
+                iterator& operator= (const iterator& other) noexcept {
+                    //the position is taken before copying the block, which keeps self-assignment intact
+                    const T* c = at(other);
+                    rng = other.rng, block = other.block, cur = c;
+                    return *this;
+                }
+                T operator* () const noexcept { return *cur; }
+                iterator& operator++ () {
+                    //moves to the next value of the block, drawing the next block after its last one
+                    if (++cur == block.data() + detail::block_size) refill();
+                    return *this;
+                }
+                void operator++ (int) { ++*this; }
+                friend bool operator== (const iterator&, std::default_sentinel_t) noexcept { return false; }
+            private:
+                void refill () {
+                    //only the raw outputs are passed to the engine, as passing out the address of the block (and thus of
+                    //the iterator) would keep cur in memory rather than in a register
+                    std::uint32_t raw[detail::block_size];
+                    rng->generate(raw, raw + detail::block_size);
+                    detail::map_block(raw, block);
+                    cur = block.data();
+                }
+                const T* at (const iterator& other) const noexcept {
+                    //returns the position of another iterator within this one's block
+                    return other.cur ? block.data() + (other.cur - other.block.data()) : nullptr;
+                }
+                Engine* rng = nullptr;
+                std::array<T, detail::block_size> block{};
+                const T* cur = nullptr;
+            };
+            uniform_view () = default;
+            explicit uniform_view (Engine& rng) noexcept : rng(&rng) {}
+            iterator begin () const {
+                //draws the first block, so like std::ranges::istream_view every call starts where the generator is now
+                return iterator(rng);
+            }
+            std::default_sentinel_t end () const noexcept { return std::default_sentinel; }
+        private:
+            Engine* rng = nullptr;
+        };
+        template <class T, class Engine> uniform_view<T, Engine> uniform (Engine& rng) noexcept {
+            //returns an infinite view of uniform values of type T drawn in blocks from the generator
+            return uniform_view<T, Engine>(rng);
+        }
+    }
+    #ifdef __cpp_impl_coroutine
+        template <class T> class generator : public std::ranges::view_interface<generator<T>> {
+        public:
+            struct promise_type {
+                T value{};
+                generator get_return_object () noexcept {
+                    return generator(std::coroutine_handle<promise_type>::from_promise(*this));
+                }
+                std::suspend_always initial_suspend () const noexcept { return {}; }
+                std::suspend_always final_suspend () const noexcept { return {}; }
+                std::suspend_always yield_value (T v) noexcept {
+                    value = v;
+                    return {};
+                }
+                void return_void () const noexcept {}
+                void unhandled_exception () const noexcept { std::terminate(); }
+            };
+            class iterator {
+            public:
+                using iterator_concept = std::input_iterator_tag;
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+                iterator () = default;
+                explicit iterator (std::coroutine_handle<promise_type> handle) noexcept : handle(handle) {}
+                T operator* () const noexcept { return handle.promise().value; }
+                iterator& operator++ () {
+                    handle.resume();
+                    return *this;
+                }
+                void operator++ (int) { ++*this; }
+                friend bool operator== (const iterator& i, std::default_sentinel_t) noexcept { return i.handle.done(); }
+            private:
+                std::coroutine_handle<promise_type> handle;
+            };
+            generator () = default;
+            generator (generator&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+            generator& operator= (generator&& other) noexcept {
+                std::swap(handle, other.handle);
+                return *this;
+            }
+            ~generator () {
+                if (handle) handle.destroy();
+            }
+            iterator begin () {
+                //runs the coroutine up to its first value, so this should only be called once
+                handle.resume();
+                return iterator(handle);
+            }
+            std::default_sentinel_t end () const noexcept { return std::default_sentinel; }
+        private:
+            explicit generator (std::coroutine_handle<promise_type> handle) noexcept : handle(handle) {}
+            std::coroutine_handle<promise_type> handle;
+        };
+        template <class T, class Engine> generator<T> generate (Engine& rng) {
+            //coroutine yielding uniform values of type T drawn in blocks from the generator, like views::uniform
+            std::array<T, detail::block_size> block;
+            for (;;) {
+                detail::fill_block(rng, block);
+                for (T x : block)
+                    co_yield x;
+            }
+        }
+    #endif
+#endif
+
+}
+
+#endif //RANDOMIC_HPP
@@ -0,0 +1,926 @@
+/*
+randomic_bench.c - Benchmarks for randomic.h, printing the results as JSON
+
+To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring
+rights to this software to the public domain worldwide. This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with this software.
+If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/*
+randomic_bench build:
+    cc -O2 -pthread randomic_bench.c -o randomic_bench -lm -latomic
+    Any of randomic's configuration options (e.g. -DRANDOMIC_XOSHIRO or -march=native) can be added to compare builds.
+    The header must also build warning-free in the smallest program using it the documented way, where the compiler inlines
+    far more than into this benchmark and sees what e.g. seeding does to an uninitialized generator (with the same options):
+    printf '#define RANDOMIC_STATIC\n#include "randomic.h"\nint main(void) {struct randomic r; randomicSeed(&r, 1);
+    return (int)randomicNext(&r);}\n' | cc -O2 -Wall -Wextra -Werror -Wno-unused-function -I. -x c - -o /dev/null -latomic
+
+randomic_bench usage:
+    randomic_bench [threads]
+    Runs every benchmark single-threaded, then the contended ones on 1 to threads threads (by default twice the number of
+    online cores) sharing a single struct randomic, and prints one JSON document with a result object per run to stdout.
+    randomic_bench latency [threads...]
+    Measures the latency of every single call of each concurrency strategy below instead, on each of the given numbers of
+    threads (by default 1, the number of online cores, and two and four times that to cover oversubscription), and prints
+    the median, 99th and 99.9th percentile and maximum latencies in ns as JSON. The strategies are randomicNext on a shared
+    struct randomic (cas), a mutex around a non-atomic generator (mutex), randomicNext on a per-thread generator split off the
+    shared one (split), and randomicPhiloxNext on a shared struct randomic_philox, which costs a single fetch-and-add (philox).
+    randomic_bench litmus [threads]
+    Checks that concurrent calls of randomicNext on a shared struct randomic and of randomicPhiloxNext on a shared struct
+    randomic_philox hand out every value of the sequence exactly once and in order per thread, on the given number of threads
+    (by default four times the number of online cores), printing the result as JSON and exiting with 1 if any check failed.
+    This is mostly meant for builds with RANDOMIC_RELAXED or RANDOMIC_NO_ASM, or for new targets. So far it has only been run
+    on x86-64, where it can't observe weak memory ordering, so a pass there says nothing about weakly ordered processors.
+    randomic_bench kat
+    Checks the counter-based generators against published known answer tests and their vectorized paths against the scalar
+    ones, printing the result of every check as JSON and exiting with 1 if any of them failed. Vectorized paths are only
+    checked if they were compiled in (e.g. with -march=native), so this is worth running once per build configuration.
+    randomic_bench shuffle [megabytes...]
+    Compares randomicShuffleU32 (shuffle_u32) to randomicShuffleBuckets (shuffle_buckets) on arrays of each of the given
+    sizes in MiB (by default 1 and 100), printing the results as JSON like the default run. Sizes far beyond the last level
+    cache, such as 10240 for 10 GiB, are opt-in as they need twice their size in memory and take minutes for the plain shuffle.
+
+randomic_bench details:
+    Each benchmark is calibrated until a run takes at least 20 ms, after which the fastest of five runs is reported as
+    ns_per_value and values_per_s, along with cycles_per_value from the time stamp counter on x86 (null elsewhere). The time
+    stamp counter ticks at a constant reference rate, which only matches core cycles with frequency scaling turned off.
+    Contended runs report the wall time of all threads together, so ns_per_value is the cost per value of the whole system.
+    The exception to single-threaded runs is parallel_fill, which passes the number of online cores to randomicParallelFill,
+    and thus only runs on several threads if built with -fopenmp.
+    Latencies are recorded into log-linear histograms like HdrHistogram's, with 16 sub-buckets per power of two, so every
+    percentile is reported as the upper end of its bucket with a precision of at least 1/16. They include the overhead of
+    reading the clock (the time stamp counter on x86, which is calibrated against the monotonic clock at startup).
+    The litmus check compares the values the threads got to the same number of values from a single thread, which must be the
+    same multiset, and a thread must get values that are later in the sequence with every call, which holds for atomic updates
+    of a single object regardless of memory order. As values may repeat in the sequence, only unique values are checked for
+    order. Finally the shared generator must end up in the same state as the single-threaded one, comparing the whole state
+    of struct randomic and the position of struct randomic_philox.
+    Philox4x32-10 is checked against the kat_vectors of Random123, for which the internal block function is called directly,
+    as the vectors' counters are beyond the positions a stream reaches. The eight block kernel is checked on the blocks ending
+    at each vector, and randomicPhiloxFill against randomicPhiloxAt across a block index that carries into the high word.
+    AES-128 is checked against the examples of FIPS-197 (appendices B and C.1) in software, and with AES-NI too if the CPU
+    has it, and randomicAesFill (which uses AES-NI where it can) is checked against the software path.
+    ChaCha20 is checked against the block function example of RFC 8439 (section 2.3.2) and its first keystream vector
+    (appendix A.1), and ChaCha8/12 against the all-zero key vectors of draft-strombergson-chacha-test-vectors (TC1), with the
+    generator's key and stream set directly. Like for philox, the eight block kernel is checked on the blocks ending at each
+    vector, and randomicChachaFill against randomicChachaNext for every number of rounds.
+*/
+
+#define _GNU_SOURCE
+#define RANDOMIC_STATIC
+#define RANDOMIC_SAMPLING
+#include "randomic.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #include <x86intrin.h>
+    #define RANDOMIC_BENCH_TSC
+#endif
+
+//benchmark definitions
+#define RANDOMIC_BENCH_SIZE (1 << 24)
+struct bench {
+    const char* name;
+    size_t size;
+    int contended;
+    uint32_t (*run)(size_t);
+};
+struct benchResult {
+    size_t values;
+    double ns, cycles;
+};
+struct benchThread {
+    pthread_t thread;
+    pthread_barrier_t* barrier;
+    uint32_t (*run)(size_t);
+    size_t n;
+};
+#define RANDOMIC_LATENCY_BUCKETS (61*16)
+#define RANDOMIC_LATENCY_CALLS 200000
+struct latencyThread {
+    pthread_t thread;
+    pthread_barrier_t* barrier;
+    uint32_t (*call)(struct latencyThread*);
+    struct randomic local;
+    uint64_t hist[RANDOMIC_LATENCY_BUCKETS], max;
+};
+struct latencyStrategy {
+    const char* name;
+    uint32_t (*call)(struct latencyThread*);
+};
+#define RANDOMIC_LITMUS_CALLS 250000
+struct litmusThread {
+    pthread_t thread;
+    pthread_barrier_t* barrier;
+    int counter;
+    uint32_t* out;
+};
+
+//function declarations
+static uint32_t benchNext(size_t);
+static uint32_t benchFloatCO(size_t);
+static uint32_t benchFloatCC(size_t);
+static uint32_t benchDoubleCO(size_t);
+static uint32_t benchDoubleCC(size_t);
+static uint32_t benchBounded(size_t);
+static uint32_t benchSeed(size_t);
+static uint32_t benchSeedMany(size_t);
+static uint32_t benchSpawn(size_t);
+static uint32_t benchShuffleSmall(size_t);
+static uint32_t benchShuffleMedium(size_t);
+static uint32_t benchShuffleLarge(size_t);
+static uint32_t benchShuffleBuckets(size_t);
+static uint32_t benchPermRange(size_t);
+static uint32_t benchSampleIndices(size_t);
+static uint32_t benchPoolStep(size_t);
+static uint32_t benchTeamNext(size_t);
+static uint32_t benchTeamFill(size_t);
+static uint32_t benchPhiloxNext(size_t);
+static uint32_t benchPhiloxFill(size_t);
+static uint32_t benchAesFill(size_t);
+static uint32_t benchChachaFill(size_t);
+static uint32_t benchParallelFill(size_t);
+static double benchNow(void);
+static double benchCycles(void);
+static struct benchResult benchMeasure(const struct bench*, int, size_t);
+static void* benchWorker(void*);
+static void benchPrint(const struct bench*, int, struct benchResult, int*);
+static uint32_t latencyCas(struct latencyThread*);
+static uint32_t latencyMutex(struct latencyThread*);
+static uint32_t latencySplit(struct latencyThread*);
+static uint32_t latencyPhilox(struct latencyThread*);
+static int latencyMain(int, char**);
+static void latencyRun(const struct latencyStrategy*, int, int*);
+static void* latencyWorker(void*);
+static uint64_t latencyTicks(void);
+static int latencyBucket(uint64_t);
+static uint64_t latencyBound(int);
+static int litmusMain(int, char**);
+static int katMain(void);
+static int katPhilox(int*);
+static int katAes(int*);
+static int katChacha(int*);
+static int katCheck(const char*, const char*, const uint32_t*, const uint32_t*, size_t, int*);
+static int shuffleMain(int, char**);
+static uint32_t shuffleNaive(size_t);
+static uint32_t shuffleBuckets(size_t);
+static int litmusRun(int, int, int*);
+static void* litmusWorker(void*);
+static int litmusCompare(const void*, const void*);
+static int litmusCompare32(const void*, const void*);
+
+//benchmark state
+static struct randomic shared;
+static struct randomic many[4096];
+static struct randomic_pool pool;
+static struct randomic_team team;
+static struct randomic_philox philox;
+static struct randomic_aes aes;
+static struct randomic_chacha chacha;
+static uint32_t *buffer, *temp;
+static uint64_t *indices;
+static struct randomic_pool locked;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static double tickNs = 1.0;
+static int fillThreads = 1;
+static const struct latencyStrategy strategies[] = {
+    {"cas", latencyCas},
+    {"mutex", latencyMutex},
+    {"split", latencySplit},
+    {"philox", latencyPhilox},
+};
+static const struct bench benches[] = {
+    {"next", 1, 1, benchNext},
+    {"float_co", 1, 1, benchFloatCO},
+    {"float_cc", 1, 1, benchFloatCC},
+    {"double_co", 1, 1, benchDoubleCO},
+    {"double_cc", 1, 1, benchDoubleCC},
+    {"bounded", 1, 1, benchBounded},
+    {"seed", 1, 0, benchSeed},
+    {"seed_many", 4096, 0, benchSeedMany},
+    {"spawn", 1, 0, benchSpawn},
+    {"shuffle_u32_1k", 1024, 0, benchShuffleSmall},
+    {"shuffle_u32_1m", 1 << 20, 0, benchShuffleMedium},
+    {"shuffle_u32_16m", RANDOMIC_BENCH_SIZE, 0, benchShuffleLarge},
+    {"shuffle_buckets_16m", RANDOMIC_BENCH_SIZE, 0, benchShuffleBuckets},
+    {"perm_range", 4096, 0, benchPermRange},
+    {"sample_indices", 4096, 0, benchSampleIndices},
+    {"pool_step", 4096, 0, benchPoolStep},
+    {"team_next", 1, 0, benchTeamNext},
+    {"team_fill", 4096, 0, benchTeamFill},
+    {"philox_next", 1, 1, benchPhiloxNext},
+    {"philox_fill", 4096, 0, benchPhiloxFill},
+    {"aes_fill", 4096, 0, benchAesFill},
+    {"chacha_fill", 4096, 0, benchChachaFill},
+    {"parallel_fill", RANDOMIC_BENCH_SIZE, 0, benchParallelFill},
+};
+
+int main (int argc, char** argv) {
+    //runs every benchmark single-threaded, then the contended ones on 1 to the given number of threads
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = argc > 1 ? atoi(argv[1]) : (int)(cores > 0 ? 2*cores : 2), first = 1;
+    if (argc > 1 && !strcmp(argv[1], "latency"))
+        return latencyMain(argc - 2, argv + 2);
+    if (argc > 1 && !strcmp(argv[1], "litmus"))
+        return litmusMain(argc - 2, argv + 2);
+    if (argc > 1 && !strcmp(argv[1], "kat"))
+        return katMain();
+    if (argc > 1 && !strcmp(argv[1], "shuffle"))
+        return shuffleMain(argc - 2, argv + 2);
+    buffer = malloc(RANDOMIC_BENCH_SIZE*sizeof(uint32_t));
+    temp = malloc(RANDOMIC_BENCH_SIZE*sizeof(uint32_t));
+    indices = malloc(4096*sizeof(uint64_t));
+    if (!buffer || !temp || !indices || !randomicPoolInit(&pool, 4096) || !randomicTeamInit(&team, 1) || threads < 1) {
+        fprintf(stderr, "randomic_bench: setup failed\n");
+        return 1;
+    }
+    for (size_t i = 0; i < RANDOMIC_BENCH_SIZE; i++)
+        buffer[i] = (uint32_t)i;
+    fillThreads = cores > 0 ? (int)cores : 1;
+    randomicSeed(&shared, 1);
+    randomicPoolSpawn(&pool, 1);
+    randomicTeamSpawn(&team, 1);
+    randomicPhiloxSeed(&philox, 1, 0);
+    randomicAesSeed(&aes, 1, 0);
+    randomicChachaSeed(&chacha, 1, 0, 8);
+    printf("{\n  \"engine\": \"%s\",\n", RANDOMIC_ENGINE);
+    #ifdef __VERSION__
+        printf("  \"compiler\": \"%s\",\n", __VERSION__);
+    #endif
+    printf("  \"cores\": %ld,\n  \"lock_free\": %d,\n", cores, randomicIsLockFree());
+    #ifdef RANDOMIC_RELAXED
+        printf("  \"relaxed\": 1,\n");
+    #else
+        printf("  \"relaxed\": 0,\n");
+    #endif
+    printf("  \"aes_hardware\": %d,\n  \"results\": [", randomicAesHardware());
+    for (size_t b = 0; b < sizeof(benches)/sizeof(benches[0]); b++) {
+        //calibrates on a single thread until a run takes long enough to time reliably
+        size_t n = benches[b].size;
+        struct benchResult r = benchMeasure(&benches[b], 1, n);
+        while (r.ns < 2e7) {
+            n *= 2;
+            r = benchMeasure(&benches[b], 1, n);
+        }
+        for (int i = 0; i < 4; i++) {
+            struct benchResult s = benchMeasure(&benches[b], 1, n);
+            if (s.ns < r.ns) r = s;
+        }
+        benchPrint(&benches[b], 1, r, &first);
+        if (!benches[b].contended) continue;
+        for (int t = 2; t <= threads; t++) {
+            r = benchMeasure(&benches[b], t, n);
+            for (int i = 0; i < 4; i++) {
+                struct benchResult s = benchMeasure(&benches[b], t, n);
+                if (s.ns < r.ns) r = s;
+            }
+            benchPrint(&benches[b], t, r, &first);
+        }
+    }
+    printf("\n  ]\n}\n");
+    randomicPoolFree(&pool);
+    randomicTeamFree(&team);
+    free(buffer);
+    free(temp);
+    free(indices);
+    return 0;
+}
+
+//benchmarks, each producing n values and returning something derived from them so they can't be optimized away
+static uint32_t benchNext (size_t n) {
+    uint32_t x = 0;
+    for (size_t i = 0; i < n; i++)
+        x += randomicNext(&shared);
+    return x;
+}
+static uint32_t benchFloatCO (size_t n) {
+    float x = 0.0f;
+    for (size_t i = 0; i < n; i++)
+        x += randomicFloatCO(&shared);
+    return (uint32_t)x;
+}
+static uint32_t benchFloatCC (size_t n) {
+    float x = 0.0f;
+    for (size_t i = 0; i < n; i++)
+        x += randomicFloatCC(&shared);
+    return (uint32_t)x;
+}
+static uint32_t benchDoubleCO (size_t n) {
+    double x = 0.0;
+    for (size_t i = 0; i < n; i++)
+        x += randomicDoubleCO(&shared);
+    return (uint32_t)x;
+}
+static uint32_t benchDoubleCC (size_t n) {
+    double x = 0.0;
+    for (size_t i = 0; i < n; i++)
+        x += randomicDoubleCC(&shared);
+    return (uint32_t)x;
+}
+static uint32_t benchBounded (size_t n) {
+    uint32_t x = 0;
+    for (size_t i = 0; i < n; i++)
+        x += randomicBounded(&shared, 1000000007);
+    return x;
+}
+static uint32_t benchSeed (size_t n) {
+    struct randomic local;
+    for (size_t i = 0; i < n; i++)
+        randomicSeed(&local, (uint32_t)i);
+    return randomicNext(&local);
+}
+static uint32_t benchSeedMany (size_t n) {
+    uint32_t x = 0;
+    for (size_t i = 0; i < n; i += 4096) {
+        randomicSeedMany(many, buffer + i%RANDOMIC_BENCH_SIZE, 4096);
+        x += randomicNext(&many[i%4096]);
+    }
+    return x;
+}
+static uint32_t benchSpawn (size_t n) {
+    struct randomic local;
+    for (size_t i = 0; i < n; i++)
+        randomicSpawn(&local, 1, i);
+    return randomicNext(&local);
+}
+static uint32_t benchShuffleSmall (size_t n) {
+    for (size_t i = 0; i < n; i += 1024)
+        randomicShuffleU32(&shared, buffer + i%RANDOMIC_BENCH_SIZE, 1024);
+    return buffer[0];
+}
+static uint32_t benchShuffleMedium (size_t n) {
+    for (size_t i = 0; i < n; i += 1 << 20)
+        randomicShuffleU32(&shared, buffer, 1 << 20);
+    return buffer[0];
+}
+static uint32_t benchShuffleLarge (size_t n) {
+    for (size_t i = 0; i < n; i += RANDOMIC_BENCH_SIZE)
+        randomicShuffleU32(&shared, buffer, RANDOMIC_BENCH_SIZE);
+    return buffer[0];
+}
+static uint32_t benchShuffleBuckets (size_t n) {
+    for (size_t i = 0; i < n; i += RANDOMIC_BENCH_SIZE)
+        randomicShuffleBuckets(&shared, buffer, temp, RANDOMIC_BENCH_SIZE, sizeof(uint32_t));
+    return buffer[0];
+}
+static uint32_t benchPermRange (size_t n) {
+    struct randomic_perm perm;
+    randomicPermInit(&perm, &shared, 1000000007);
+    for (size_t i = 0; i < n; i += 4096)
+        randomicPermRange(&perm, i, indices, 4096);
+    return (uint32_t)indices[0];
+}
+static uint32_t benchSampleIndices (size_t n) {
+    for (size_t i = 0; i < n; i += 4096)
+        randomicSampleIndices(&shared, 1 << 20, 4096, indices);
+    return (uint32_t)indices[0];
+}
+static uint32_t benchPoolStep (size_t n) {
+    for (size_t i = 0; i < n; i += 4096)
+        randomicPoolStep(&pool, buffer);
+    return buffer[0];
+}
+static uint32_t benchTeamNext (size_t n) {
+    uint32_t x = 0;
+    for (size_t i = 0; i < n; i++)
+        x += randomicTeamNext(&team);
+    return x;
+}
+static uint32_t benchTeamFill (size_t n) {
+    for (size_t i = 0; i < n; i += 4096)
+        randomicTeamFill(&team, buffer, 4096);
+    return buffer[0];
+}
+static uint32_t benchPhiloxNext (size_t n) {
+    uint32_t x = 0;
+    for (size_t i = 0; i < n; i++)
+        x += randomicPhiloxNext(&philox);
+    return x;
+}
+static uint32_t benchPhiloxFill (size_t n) {
+    for (size_t i = 0; i < n; i += 4096)
+        randomicPhiloxFill(&philox, buffer, 4096);
+    return buffer[0];
+}
+static uint32_t benchAesFill (size_t n) {
+    for (size_t i = 0; i < n; i += 4096)
+        randomicAesFill(&aes, buffer, 4096);
+    return buffer[0];
+}
+static uint32_t benchChachaFill (size_t n) {
+    for (size_t i = 0; i < n; i += 4096)
+        randomicChachaFill(&chacha, buffer, 4096);
+    return buffer[0];
+}
+
+static uint32_t benchParallelFill (size_t n) {
+    for (size_t i = 0; i < n; i += RANDOMIC_BENCH_SIZE)
+        randomicParallelFill(i, buffer, RANDOMIC_BENCH_SIZE*sizeof(uint32_t), fillThreads);
+    return buffer[0];
+}
+
+//harness
+static double benchNow (void) {
+    //returns a monotonic time in nanoseconds
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec*1e9 + (double)t.tv_nsec;
+}
+static double benchCycles (void) {
+    //returns the time stamp counter where available, 0 otherwise
+    #ifdef RANDOMIC_BENCH_TSC
+        return (double)__rdtsc();
+    #else
+        return 0.0;
+    #endif
+}
+static struct benchResult benchMeasure (const struct bench* b, int threads, size_t n) {
+    //runs a benchmark for n values per thread, with all threads released together by a barrier
+    struct benchResult r;
+    r.values = n*(size_t)threads;
+    if (threads == 1) {
+        volatile uint32_t sink;
+        double t0 = benchNow(), c0 = benchCycles();
+        sink = b->run(n);
+        r.cycles = benchCycles() - c0, r.ns = benchNow() - t0;
+        (void)sink;
+        return r;
+    }
+    struct benchThread* ts = malloc((size_t)threads*sizeof(struct benchThread));
+    pthread_barrier_t barrier;
+    if (!ts) {
+        r.ns = r.cycles = 0.0;
+        return r;
+    }
+    pthread_barrier_init(&barrier, NULL, (unsigned)threads + 1);
+    for (int i = 0; i < threads; i++) {
+        ts[i].barrier = &barrier, ts[i].run = b->run, ts[i].n = n;
+        pthread_create(&ts[i].thread, NULL, benchWorker, &ts[i]);
+    }
+    pthread_barrier_wait(&barrier);
+    double t0 = benchNow(), c0 = benchCycles();
+    for (int i = 0; i < threads; i++)
+        pthread_join(ts[i].thread, NULL);
+    r.cycles = benchCycles() - c0, r.ns = benchNow() - t0;
+    pthread_barrier_destroy(&barrier);
+    free(ts);
+    return r;
+}
+static void* benchWorker (void* arg) {
+    //runs the benchmark of a single contending thread
+    struct benchThread* t = arg;
+    volatile uint32_t sink;
+    pthread_barrier_wait(t->barrier);
+    sink = t->run(t->n);
+    (void)sink;
+    return NULL;
+}
+static void benchPrint (const struct bench* b, int threads, struct benchResult r, int* first) {
+    //prints a single result object, separated from the previous one
+    printf("%s\n    {\"name\": \"%s\", \"threads\": %d, \"values\": %zu, \"ns_per_value\": %.4f, \"values_per_s\": %.6g, ",
+        *first ? "" : ",", b->name, threads, r.values, r.ns/(double)r.values, (double)r.values/r.ns*1e9);
+    #ifdef RANDOMIC_BENCH_TSC
+        printf("\"cycles_per_value\": %.4f}", r.cycles/(double)r.values);
+    #else
+        printf("\"cycles_per_value\": null}");
+    #endif
+    *first = 0;
+    fflush(stdout);
+}
+
+//latency harness
+static uint32_t latencyCas (struct latencyThread* t) {
+    (void)t;
+    return randomicNext(&shared);
+}
+static uint32_t latencyMutex (struct latencyThread* t) {
+    (void)t;
+    pthread_mutex_lock(&mutex);
+    uint32_t x = randomicPoolNext(&locked, 0);
+    pthread_mutex_unlock(&mutex);
+    return x;
+}
+static uint32_t latencySplit (struct latencyThread* t) {
+    return randomicNext(&t->local);
+}
+static uint32_t latencyPhilox (struct latencyThread* t) {
+    (void)t;
+    return randomicPhiloxNext(&philox);
+}
+static int latencyMain (int argc, char** argv) {
+    //runs every strategy on each of the given thread counts
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int counts[16], n = 0, first = 1;
+    for (int i = 0; i < argc && n < 16; i++)
+        if (atoi(argv[i]) > 0) counts[n++] = atoi(argv[i]);
+    if (!n) {
+        counts[n++] = 1;
+        if (cores > 1) counts[n++] = (int)cores;
+        counts[n++] = (int)(cores > 0 ? 2*cores : 2);
+        counts[n++] = (int)(cores > 0 ? 4*cores : 4);
+    }
+    if (!randomicPoolInit(&locked, 1)) {
+        fprintf(stderr, "randomic_bench: setup failed\n");
+        return 1;
+    }
+    randomicSeed(&shared, 1);
+    randomicPoolSpawn(&locked, 1);
+    randomicPhiloxSeed(&philox, 1, 0);
+    #ifdef RANDOMIC_BENCH_TSC
+        //calibrates the time stamp counter against the monotonic clock
+        double t0 = benchNow(), c0 = benchCycles(), t1;
+        while ((t1 = benchNow()) - t0 < 5e7);
+        tickNs = (t1 - t0)/(benchCycles() - c0);
+    #endif
+    printf("{\n  \"engine\": \"%s\",\n  \"cores\": %ld,\n  \"latency\": [", RANDOMIC_ENGINE, cores);
+    for (size_t s = 0; s < sizeof(strategies)/sizeof(strategies[0]); s++)
+        for (int i = 0; i < n; i++)
+            latencyRun(&strategies[s], counts[i], &first);
+    printf("\n  ]\n}\n");
+    randomicPoolFree(&locked);
+    return 0;
+}
+static void latencyRun (const struct latencyStrategy* s, int threads, int* first) {
+    //runs a strategy on the given number of threads and prints the percentiles of their merged histograms
+    struct latencyThread* ts = malloc((size_t)threads*sizeof(struct latencyThread));
+    pthread_barrier_t barrier;
+    uint64_t hist[RANDOMIC_LATENCY_BUCKETS] = {0}, max = 0, total = 0, seen = 0;
+    double q[3] = {0.5, 0.99, 0.999}, p[3] = {0.0, 0.0, 0.0};
+    if (!ts) return;
+    pthread_barrier_init(&barrier, NULL, (unsigned)threads);
+    for (int i = 0; i < threads; i++) {
+        ts[i].barrier = &barrier, ts[i].call = s->call;
+        randomicSplit(&shared, &ts[i].local);
+        pthread_create(&ts[i].thread, NULL, latencyWorker, &ts[i]);
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(ts[i].thread, NULL);
+        for (int b = 0; b < RANDOMIC_LATENCY_BUCKETS; b++)
+            hist[b] += ts[i].hist[b], total += ts[i].hist[b];
+        if (ts[i].max > max) max = ts[i].max;
+    }
+    for (int b = 0, j = 0; b < RANDOMIC_LATENCY_BUCKETS && j < 3; b++)
+        for (seen += hist[b]; j < 3 && (double)seen >= q[j]*(double)total; j++)
+            p[j] = (double)latencyBound(b)*tickNs;
+    printf("%s\n    {\"strategy\": \"%s\", \"threads\": %d, \"calls\": %llu, \"p50_ns\": %.1f, \"p99_ns\": %.1f, "
+        "\"p999_ns\": %.1f, \"max_ns\": %.1f}", *first ? "" : ",", s->name, threads, (unsigned long long)total,
+        p[0], p[1], p[2], (double)max*tickNs);
+    *first = 0;
+    fflush(stdout);
+    pthread_barrier_destroy(&barrier);
+    free(ts);
+}
+static void* latencyWorker (void* arg) {
+    //times every call of a strategy separately, recording it in the thread's own histogram
+    struct latencyThread* t = arg;
+    volatile uint32_t sink;
+    memset(t->hist, 0, sizeof(t->hist));
+    t->max = 0;
+    pthread_barrier_wait(t->barrier);
+    for (int i = 0; i < RANDOMIC_LATENCY_CALLS; i++) {
+        uint64_t t0 = latencyTicks();
+        sink = t->call(t);
+        uint64_t d = latencyTicks() - t0;
+        t->hist[latencyBucket(d)]++;
+        if (d > t->max) t->max = d;
+    }
+    (void)sink;
+    return NULL;
+}
+static uint64_t latencyTicks (void) {
+    //returns the time stamp counter where available, nanoseconds of the monotonic clock otherwise
+    #ifdef RANDOMIC_BENCH_TSC
+        return __rdtsc();
+    #else
+        return (uint64_t)benchNow();
+    #endif
+}
+static int latencyBucket (uint64_t v) {
+    //maps a latency to its log-linear bucket, values below 16 get a bucket each and every power of two above 16 buckets
+    int e = 0;
+    if (v < 16) return (int)v;
+    while (v >> e >> 5) e++;
+    return (e + 1)*16 + (int)(v >> e & 15);
+}
+static uint64_t latencyBound (int b) {
+    //returns the largest latency that maps to a bucket
+    if (b < 16) return (uint64_t)b;
+    return ((uint64_t)(16 + b%16 + 1) << (b/16 - 1)) - 1;
+}
+
+//litmus check
+static int litmusMain (int argc, char** argv) {
+    //checks both shared generators on the given number of threads
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = argc > 0 ? atoi(argv[0]) : (int)(cores > 0 ? 4*cores : 4), first = 1, ok;
+    if (threads < 1) {
+        fprintf(stderr, "randomic_bench: setup failed\n");
+        return 1;
+    }
+    printf("{\n  \"engine\": \"%s\",\n  \"lock_free\": %d,\n", RANDOMIC_ENGINE, randomicIsLockFree());
+    #ifdef RANDOMIC_RELAXED
+        printf("  \"relaxed\": 1,\n");
+    #else
+        printf("  \"relaxed\": 0,\n");
+    #endif
+    printf("  \"litmus\": [");
+    ok = litmusRun(threads, 0, &first);
+    ok &= litmusRun(threads, 1, &first);
+    printf("\n  ]\n}\n");
+    return !ok;
+}
+static int litmusRun (int threads, int counter, int* first) {
+    //runs the threads against one shared generator and checks their values against a single-threaded replica
+    size_t n = (size_t)threads*RANDOMIC_LITMUS_CALLS, missing = 0, order = 0;
+    struct litmusThread* ts = malloc((size_t)threads*sizeof(struct litmusThread));
+    uint32_t *all = malloc(n*sizeof(uint32_t)), *sorted = malloc(n*sizeof(uint32_t));
+    uint64_t* serial = malloc(n*sizeof(uint64_t));
+    struct randomic replica;
+    struct randomic_philox preplica;
+    pthread_barrier_t barrier;
+    int same;
+    if (!ts || !all || !sorted || !serial) {
+        free(ts), free(all), free(sorted), free(serial);
+        fprintf(stderr, "randomic_bench: setup failed\n");
+        return 0;
+    }
+    randomicSeed(&shared, 1), randomicSeed(&replica, 1);
+    randomicPhiloxSeed(&philox, 1, 0), randomicPhiloxSeed(&preplica, 1, 0);
+    pthread_barrier_init(&barrier, NULL, (unsigned)threads);
+    for (int i = 0; i < threads; i++) {
+        ts[i].barrier = &barrier, ts[i].counter = counter, ts[i].out = all + (size_t)i*RANDOMIC_LITMUS_CALLS;
+        pthread_create(&ts[i].thread, NULL, litmusWorker, &ts[i]);
+    }
+    for (int i = 0; i < threads; i++)
+        pthread_join(ts[i].thread, NULL);
+    pthread_barrier_destroy(&barrier);
+    //pairs every value of the replica with its position, sorted by value with positions of repeated values marked
+    for (size_t i = 0; i < n; i++)
+        serial[i] = (uint64_t)(counter ? randomicPhiloxNext(&preplica) : randomicNext(&replica)) << 32|(uint32_t)i;
+    if (counter) same = atomic_load(&preplica.pos) == atomic_load(&philox.pos);
+    else {
+        //compares whole states, as different states may still produce the same next value
+        struct randomic_ctx r = randomicLoad(&replica), s = randomicLoad(&shared);
+        same = !memcmp(&r, &s, sizeof(r));
+    }
+    qsort(serial, n, sizeof(uint64_t), litmusCompare);
+    for (size_t i = 0; i < n; i++) {
+        sorted[i] = (uint32_t)(serial[i] >> 32);
+        if ((i && sorted[i] == sorted[i - 1]) || (i + 1 < n && serial[i + 1] >> 32 == sorted[i]))
+            serial[i] |= 0xffffffff;
+    }
+    //the values of each thread must appear at increasing positions of the replica
+    for (int t = 0; t < threads; t++) {
+        uint64_t last = 0;
+        int started = 0;
+        for (size_t i = 0; i < RANDOMIC_LITMUS_CALLS; i++) {
+            uint32_t v = ts[t].out[i];
+            size_t lo = 0, hi = n;
+            while (lo < hi) {
+                size_t mid = lo + (hi - lo)/2;
+                if (sorted[mid] < v) lo = mid + 1;
+                else hi = mid;
+            }
+            if (lo == n || sorted[lo] != v || (uint32_t)serial[lo] == 0xffffffff) continue;
+            if (started && (uint32_t)serial[lo] <= last) order++;
+            last = (uint32_t)serial[lo], started = 1;
+        }
+    }
+    //the values of all threads together must be the same multiset as those of the replica
+    qsort(all, n, sizeof(uint32_t), litmusCompare32);
+    for (size_t i = 0; i < n; i++)
+        missing += all[i] != sorted[i];
+    printf("%s\n    {\"generator\": \"%s\", \"threads\": %d, \"calls\": %zu, \"mismatched\": %zu, \"out_of_order\": %zu, "
+        "\"same_final_state\": %d, \"pass\": %d}", *first ? "" : ",", counter ? "philox" : "randomic", threads, n, missing,
+        order, same, !missing && !order && same);
+    *first = 0;
+    fflush(stdout);
+    free(ts), free(all), free(sorted), free(serial);
+    return !missing && !order && same;
+}
+static void* litmusWorker (void* arg) {
+    //stores the values of every call of a contending thread
+    struct litmusThread* t = arg;
+    pthread_barrier_wait(t->barrier);
+    for (size_t i = 0; i < RANDOMIC_LITMUS_CALLS; i++)
+        t->out[i] = t->counter ? randomicPhiloxNext(&philox) : randomicNext(&shared);
+    return NULL;
+}
+static int litmusCompare (const void* x, const void* y) {
+    //orders uint64 values for qsort
+    uint64_t a = *(const uint64_t*)x, b = *(const uint64_t*)y;
+    return (a > b) - (a < b);
+}
+static int litmusCompare32 (const void* x, const void* y) {
+    //orders uint32 values for qsort
+    uint32_t a = *(const uint32_t*)x, b = *(const uint32_t*)y;
+    return (a > b) - (a < b);
+}
+
+//known answer tests
+static int katMain (void) {
+    //runs the checks of every counter-based generator
+    int first = 1, ok;
+    printf("{\n  \"engine\": \"%s\",\n", RANDOMIC_ENGINE);
+    #ifdef __AVX2__
+        printf("  \"avx2\": 1,\n");
+    #else
+        printf("  \"avx2\": 0,\n");
+    #endif
+    printf("  \"aesni\": %d,\n  \"kat\": [", randomicAesHardware());
+    ok = katPhilox(&first);
+    ok &= katAes(&first);
+    ok &= katChacha(&first);
+    printf("\n  ]\n}\n");
+    return !ok;
+}
+static int katPhilox (int* first) {
+    //checks philox against the Random123 vectors, then the eight block kernel and the stream functions against the scalar block
+    static const struct {
+        const char* name;
+        uint32_t key[2], ctr[4], out[4];
+    } vectors[] = {
+        {"random123_zeros", {0, 0}, {0, 0, 0, 0}, {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+        {"random123_ones", {0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+            {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+        {"random123_pi", {0xa4093822, 0x299f31d0}, {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+            {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}},
+    };
+    uint32_t out[64], want[64];
+    struct randomic_philox phx;
+    char name[32];
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(vectors)/sizeof(vectors[0]); i++) {
+        uint64_t block = vectors[i].ctr[0]|(uint64_t)vectors[i].ctr[1] << 32;
+        uint64_t stream = vectors[i].ctr[2]|(uint64_t)vectors[i].ctr[3] << 32;
+        randomicPhiloxBlock(vectors[i].key, block, stream, out);
+        ok &= katCheck("philox", vectors[i].name, out, vectors[i].out, 4, first);
+        randomicPhiloxBlocks(vectors[i].key, block - 7, stream, out);
+        snprintf(name, sizeof(name), "%s_blocks", vectors[i].name);
+        ok &= katCheck("philox", name, out + 28, vectors[i].out, 4, first);
+    }
+    //a fill of 64 values from position 4*(2^32 - 8) + 2 takes the eight block kernel across the carry into the high word
+    randomicPhiloxSeed(&phx, 0x299f31d0a4093822, 0x0370734413198a2e);
+    randomicPhiloxSeek(&phx, 4*((uint64_t)1 << 32) - 30);
+    randomicPhiloxFill(&phx, out, 64);
+    for (int i = 0; i < 64; i++)
+        want[i] = randomicPhiloxAt(0x299f31d0a4093822, 0x0370734413198a2e, 4*((uint64_t)1 << 32) - 30 + (uint64_t)i);
+    ok &= katCheck("philox", "fill_parity", out, want, 64, first);
+    return ok;
+}
+static int katAes (int* first) {
+    //checks the software aes and AES-NI against FIPS-197, then the stream functions against the software path
+    //key, plaintext and ciphertext bytes are read as little-endian words, the order in which the generator lays them out
+    static const struct {
+        const char* name;
+        uint64_t key[2], block, stream;
+        uint32_t out[4];
+    } vectors[] = {
+        {"fips197_b", {0xa6d2ae2816157e2b, 0x3c4fcf098815f7ab}, 0x8d305a88a8f64332, 0x340737e0a2983131,
+            {0x1d842539, 0xfb09dc02, 0x978511dc, 0x320b6a19}},
+        {"fips197_c1", {0x0706050403020100, 0x0f0e0d0c0b0a0908}, 0x7766554433221100, 0xffeeddccbbaa9988,
+            {0xd8e0c469, 0x30047b6a, 0x80b7cdd8, 0x5ac5b470}},
+    };
+    uint8_t rk[176];
+    uint32_t out[64], want[64];
+    struct randomic_aes aes;
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(vectors)/sizeof(vectors[0]); i++) {
+        randomicAesExpand(rk, vectors[i].key[0], vectors[i].key[1]);
+        randomicAesSoft(rk, vectors[i].block, vectors[i].stream, out);
+        ok &= katCheck("aes", vectors[i].name, out, vectors[i].out, 4, first);
+        #ifdef RANDOMIC_AESNI
+            if (randomicAesHardware()) {
+                char name[32];
+                randomicAesNI(rk, vectors[i].block, vectors[i].stream, out, 1);
+                snprintf(name, sizeof(name), "%s_aesni", vectors[i].name);
+                ok &= katCheck("aes", name, out, vectors[i].out, 4, first);
+            }
+        #endif
+    }
+    //a fill of 64 values from position 2 takes both the single block and the eight block paths of AES-NI
+    randomicAesSeed(&aes, 1, 2);
+    randomicAesSeek(&aes, 2);
+    randomicAesFill(&aes, out, 64);
+    for (int i = 0; i < 17; i++) {
+        uint32_t w[4];
+        randomicAesSoft(aes.keys, (uint64_t)i, 2, w);
+        for (int j = 0; j < 4; j++)
+            if (4*i + j >= 2 && 4*i + j < 66) want[4*i + j - 2] = w[j];
+    }
+    ok &= katCheck("aes", "fill_parity", out, want, 64, first);
+    return ok;
+}
+static int katChacha (int* first) {
+    //checks chacha against RFC 8439 and the reduced round vectors, then the eight block kernel and the stream functions
+    static const struct {
+        const char* name;
+        int rounds;
+        uint32_t key[8];
+        uint64_t block, stream;
+        uint32_t out[16];
+    } vectors[] = {
+        {"tc1_chacha8", 8, {0}, 0, 0,
+            {0x2fef003e, 0xd6405f89, 0xe8b85b7f, 0xa1a5091f, 0xc30e842c, 0x3b7f9ace, 0x88e11b18, 0x1e1a71ef,
+            0x72e14c98, 0x416f21b9, 0x6753449f, 0x19566d45, 0xa3424a31, 0x01b086da, 0xb8fd7b38, 0x42fe0c0e}},
+        {"tc1_chacha12", 12, {0}, 0, 0,
+            {0x6a9af49b, 0x53f95507, 0x12ce1f81, 0xd583265f, 0xbbc32904, 0x1474e049, 0xa589007e, 0x5f15ae2e,
+            0x79f86405, 0xc0e37ad2, 0x3428e82c, 0x798cfaac, 0x2c9f623a, 0x1969dea0, 0x2fe80b61, 0xbe261341}},
+        {"rfc8439_a1", 20, {0}, 0, 0,
+            {0xade0b876, 0x903df1a0, 0xe56a5d40, 0x28bd8653, 0xb819d2bd, 0x1aed8da0, 0xccef36a8, 0xc70d778b,
+            0x7c5941da, 0x8d485751, 0x3fe02477, 0x374ad8b8, 0xf4b8436a, 0x1ca11815, 0x69b687c3, 0x8665eeb2}},
+        {"rfc8439_2_3_2", 20, {0x03020100, 0x07060504, 0x0b0a0908, 0x0f0e0d0c, 0x13121110, 0x17161514, 0x1b1a1918, 0x1f1e1d1c},
+            0x0900000000000001, 0x4a000000,
+            {0xe4e7f110, 0x15593bd1, 0x1fdd0f50, 0xc47120a3, 0xc7f4d1c7, 0x0368c033, 0x9aaa2204, 0x4e6cd4c3,
+            0x466482d2, 0x09aa9f07, 0x05d7c214, 0xa2028bd9, 0xd19c12b5, 0xb94e16de, 0xe883d0cb, 0x4e3c50a2}},
+    };
+    static const int rounds[] = {8, 12, 20};
+    uint32_t out[256], want[256];
+    struct randomic_chacha cha;
+    char name[32];
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(vectors)/sizeof(vectors[0]); i++) {
+        randomicChachaSeed(&cha, 0, vectors[i].stream, vectors[i].rounds);
+        memcpy(cha.key, vectors[i].key, sizeof(cha.key));
+        randomicChachaBlock(&cha, vectors[i].block, out);
+        ok &= katCheck("chacha", vectors[i].name, out, vectors[i].out, 16, first);
+        randomicChachaBlocks(&cha, vectors[i].block - 7, out);
+        snprintf(name, sizeof(name), "%s_blocks", vectors[i].name);
+        ok &= katCheck("chacha", name, out + 112, vectors[i].out, 16, first);
+    }
+    //a fill of 256 values from position 16*(2^32 - 8) + 5 takes the eight block kernel across the carry into the high word
+    for (size_t i = 0; i < sizeof(rounds)/sizeof(rounds[0]); i++) {
+        randomicChachaSeed(&cha, 1, 2, rounds[i]);
+        randomicChachaSeek(&cha, 16*((uint64_t)1 << 32) - 123);
+        randomicChachaFill(&cha, out, 256);
+        randomicChachaSeek(&cha, 16*((uint64_t)1 << 32) - 123);
+        for (int j = 0; j < 256; j++)
+            want[j] = randomicChachaNext(&cha);
+        snprintf(name, sizeof(name), "fill_parity_chacha%d", rounds[i]);
+        ok &= katCheck("chacha", name, out, want, 256, first);
+    }
+    return ok;
+}
+static int katCheck (const char* generator, const char* check, const uint32_t* got, const uint32_t* want, size_t n, int* first) {
+    //compares n values to the expected ones and prints the result
+    int pass = !memcmp(got, want, n*sizeof(uint32_t));
+    printf("%s\n    {\"generator\": \"%s\", \"check\": \"%s\", \"pass\": %d}", *first ? "" : ",", generator, check, pass);
+    *first = 0;
+    fflush(stdout);
+    return pass;
+}
+
+//shuffle size comparison
+static int shuffleMain (int argc, char** argv) {
+    //shuffles arrays of each of the given sizes with and without buckets
+    double sizes[16] = {1.0, 100.0};
+    int n = argc > 0 ? 0 : 2, first = 1;
+    for (int i = 0; i < argc && n < 16; i++)
+        if (atof(argv[i]) > 0.0) sizes[n++] = atof(argv[i]);
+    printf("{\n  \"engine\": \"%s\",\n  \"bucket_size\": %d,\n  \"results\": [", RANDOMIC_ENGINE, RANDOMIC_BUCKET_SIZE);
+    for (int i = 0; i < n; i++) {
+        //larger arrays are timed once, as a single run is long enough and repeating it would take minutes
+        char naive[64], buckets[64];
+        struct bench b[2] = {{naive, 0, 0, shuffleNaive}, {buckets, 0, 0, shuffleBuckets}};
+        size_t values = (size_t)(sizes[i]*1048576.0)/sizeof(uint32_t);
+        int runs = sizes[i] <= 1024.0 ? 5 : 1;
+        snprintf(naive, sizeof(naive), "shuffle_u32_%gmb", sizes[i]);
+        snprintf(buckets, sizeof(buckets), "shuffle_buckets_%gmb", sizes[i]);
+        buffer = malloc(values*sizeof(uint32_t));
+        temp = malloc(values*sizeof(uint32_t));
+        if (!buffer || !temp || !values) {
+            free(buffer), free(temp);
+            fprintf(stderr, "randomic_bench: setup failed for %g MiB\n", sizes[i]);
+            printf("\n  ]\n}\n");
+            return 1;
+        }
+        for (size_t j = 0; j < values; j++)
+            buffer[j] = (uint32_t)j;
+        randomicSeed(&shared, 1);
+        for (int k = 0; k < 2; k++) {
+            b[k].size = values;
+            struct benchResult r = benchMeasure(&b[k], 1, values);
+            for (int j = 1; j < runs; j++) {
+                struct benchResult t = benchMeasure(&b[k], 1, values);
+                if (t.ns < r.ns) r = t;
+            }
+            benchPrint(&b[k], 1, r, &first);
+        }
+        free(buffer), free(temp);
+    }
+    printf("\n  ]\n}\n");
+    return 0;
+}
+static uint32_t shuffleNaive (size_t n) {
+    randomicShuffleU32(&shared, buffer, n);
+    return buffer[0];
+}
+static uint32_t shuffleBuckets (size_t n) {
+    randomicShuffleBuckets(&shared, buffer, temp, n, sizeof(uint32_t));
+    return buffer[0];
+}
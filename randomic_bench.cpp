@@ -0,0 +1,156 @@
+/*
+randomic_bench.cpp - Benchmarks for randomic.hpp's ranges against hand-written loops, printing the results as JSON
+
+To the extent possible under law, the author(s) have dedicated all copyright and related and neighboring
+rights to this software to the public domain worldwide. This software is distributed without any warranty.
+You should have received a copy of the CC0 Public Domain Dedication along with this software.
+If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/*
+randomic_bench.cpp build:
+    c++ -std=c++20 -O2 randomic_bench.cpp -o randomic_bench_cpp -latomic
+    Like randomic_bench.c, any of randomic's configuration options can be added to compare builds.
+
+randomic_bench.cpp usage:
+    randomic_bench_cpp
+    Sums floats in [0, 1) drawn by a loop calling float_co (loop), a loop drawing blocks of 256 values with generate and
+    mapping them itself (block_loop), randomic::views::uniform<float> | std::views::take (view) and randomic::generate<float>
+    | std::views::take (generator), from a randomic::engine and from a randomic::atomic_engine (the atomic_ benchmarks), and
+    prints one JSON document with a result object per benchmark to stdout.
+
+randomic_bench.cpp details:
+    Runs are calibrated and reported like those of randomic_bench.c, all on a single thread. The block loop is what the
+    ranges do internally, so the difference between it and them is the cost of the range machinery.
+*/
+
+#include "randomic.hpp"
+#include <chrono>
+#include <cstdio>
+#include <ranges>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #include <x86intrin.h>
+    #define RANDOMIC_BENCH_TSC
+#endif
+#if defined(RANDOMIC_XOSHIRO)
+    #define RANDOMIC_ENGINE "xoshiro128++"
+#elif defined(RANDOMIC_PCG)
+    #define RANDOMIC_ENGINE "pcg32"
+#elif defined(RANDOMIC_ROMU)
+    #define RANDOMIC_ENGINE "romuquad32"
+#elif defined(RANDOMIC_LCG128)
+    #define RANDOMIC_ENGINE "lcg128"
+#else
+    #define RANDOMIC_ENGINE "smallprng"
+#endif
+
+//benchmark definitions
+struct bench {
+    const char* name;
+    float (*run)(std::size_t);
+};
+struct benchResult {
+    std::size_t values;
+    double ns, cycles;
+};
+
+//benchmark state
+static randomic::engine local(1);
+static randomic::atomic_engine shared(1);
+
+//benchmarks, each summing n values so they can't be optimized away
+template <class Engine> static float benchLoop (Engine& rng, std::size_t n) {
+    float x = 0.0f;
+    for (std::size_t i = 0; i < n; i++)
+        x += rng.float_co();
+    return x;
+}
+template <class Engine> static float benchBlockLoop (Engine& rng, std::size_t n) {
+    std::uint32_t raw[256];
+    float block[256], x = 0.0f;
+    for (std::size_t i = 0; i < n; i += 256) {
+        rng.generate(raw, raw + 256);
+        for (int j = 0; j < 256; j++)
+            block[j] = (float)(raw[j] >> 8)/16777216.0f;
+        for (std::size_t j = 0; j < 256 && i + j < n; j++)
+            x += block[j];
+    }
+    return x;
+}
+template <class Engine> static float benchView (Engine& rng, std::size_t n) {
+    float x = 0.0f;
+    for (float v : randomic::views::uniform<float>(rng) | std::views::take(n))
+        x += v;
+    return x;
+}
+template <class Engine> static float benchGenerator (Engine& rng, std::size_t n) {
+    float x = 0.0f;
+    for (float v : randomic::generate<float>(rng) | std::views::take(n))
+        x += v;
+    return x;
+}
+static const bench benches[] = {
+    {"loop", [](std::size_t n) { return benchLoop(local, n); }},
+    {"block_loop", [](std::size_t n) { return benchBlockLoop(local, n); }},
+    {"view", [](std::size_t n) { return benchView(local, n); }},
+    {"generator", [](std::size_t n) { return benchGenerator(local, n); }},
+    {"atomic_loop", [](std::size_t n) { return benchLoop(shared, n); }},
+    {"atomic_block_loop", [](std::size_t n) { return benchBlockLoop(shared, n); }},
+    {"atomic_view", [](std::size_t n) { return benchView(shared, n); }},
+    {"atomic_generator", [](std::size_t n) { return benchGenerator(shared, n); }},
+};
+
+//harness
+static double benchCycles () {
+    //returns the time stamp counter where available, 0 otherwise
+    #ifdef RANDOMIC_BENCH_TSC
+        return (double)__rdtsc();
+    #else
+        return 0.0;
+    #endif
+}
+static benchResult benchMeasure (const bench& b, std::size_t n) {
+    //runs a benchmark for n values
+    benchResult r{n, 0.0, 0.0};
+    volatile float sink;
+    auto t0 = std::chrono::steady_clock::now();
+    double c0 = benchCycles();
+    sink = b.run(n);
+    r.cycles = benchCycles() - c0;
+    r.ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    (void)sink;
+    return r;
+}
+
+int main () {
+    //runs every benchmark, calibrated until a run takes long enough to time reliably, and reports the fastest of five runs
+    int first = 1;
+    std::printf("{\n  \"engine\": \"%s\",\n", RANDOMIC_ENGINE);
+    #ifdef __VERSION__
+        std::printf("  \"compiler\": \"%s\",\n", __VERSION__);
+    #endif
+    std::printf("  \"lock_free\": %d,\n  \"results\": [", (int)shared.is_lock_free());
+    for (const bench& b : benches) {
+        std::size_t n = 4096;
+        benchResult r = benchMeasure(b, n);
+        while (r.ns < 2e7) {
+            n *= 2;
+            r = benchMeasure(b, n);
+        }
+        for (int i = 0; i < 4; i++) {
+            benchResult s = benchMeasure(b, n);
+            if (s.ns < r.ns) r = s;
+        }
+        std::printf("%s\n    {\"name\": \"%s\", \"threads\": 1, \"values\": %zu, \"ns_per_value\": %.4f, \"values_per_s\": %.6g, ",
+            first ? "" : ",", b.name, r.values, r.ns/(double)r.values, (double)r.values/r.ns*1e9);
+        #ifdef RANDOMIC_BENCH_TSC
+            std::printf("\"cycles_per_value\": %.4f}", r.cycles/(double)r.values);
+        #else
+            std::printf("\"cycles_per_value\": null}");
+        #endif
+        first = 0;
+        std::fflush(stdout);
+    }
+    std::printf("\n  ]\n}\n");
+    return 0;
+}